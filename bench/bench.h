@@ -0,0 +1,36 @@
+/*
+ * Copyright (C) 2025 therealblue24.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Small helpers shared by the benchmarks.
+ */
+#ifndef BENCH_H_
+#define BENCH_H_
+
+#include "util.h"
+#include <inttypes.h>
+#include <time.h>
+
+/* Monotonic time in seconds. */
+static inline double bench_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/* Print a rate line, `what` per second. */
+static inline void bench_report(const char *name, double n, const char *what,
+                                double secs)
+{
+    printf("%-28s %12.3f M%s/s  (%.3f s)\n", name, n / secs / 1e6, what,
+           secs);
+}
+
+/* Keep the compiler from optimizing `x` away. */
+#define bench_use(x) __asm__ volatile("" : : "g"(x) : "memory")
+
+#endif /* BENCH_H_ */
@@ -0,0 +1,192 @@
+/*
+ * Copyright (C) 2025 therealblue24.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Codegen benchmark: the emitter vs. the old fprintf code generator.
+ */
+#include "bench.h"
+#include "cg.h"
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define OPS (2 << 20)
+#define ROUNDS 4
+
+/* The code generator as it was, one fprintf per instruction. */
+static int cg_emit_fprintf(lex_t *lex, FILE *to)
+{
+    fprintf(to, "data $fmt = { b \"%%llu\\n\", b 0 }\n");
+    fprintf(to, "export function w $main() {\n");
+    fprintf(to, "@start\n");
+    int si = 0;
+    tokiter_t iter = { 0 };
+    token_t it;
+    while(lex_iter(lex, &iter, &it)) {
+        switch(it.toktype) {
+        case TOK_ADD:
+            fprintf(to, "%%s%d =l add %%s%d, %%s%d\n", si - 2, si - 1, si - 2);
+            si--;
+            break;
+        case TOK_SUB:
+            fprintf(to, "%%s%d =l sub %%s%d, %%s%d\n", si - 2, si - 1, si - 2);
+            si--;
+            break;
+        case TOK_MUL:
+            fprintf(to, "%%s%d =l mul %%s%d, %%s%d\n", si - 2, si - 1, si - 2);
+            si--;
+            break;
+        case TOK_DIV:
+            fprintf(to, "%%s%d =l div %%s%d, %%s%d\n", si - 2, si - 1, si - 2);
+            si--;
+            break;
+        case TOK_DUMP:
+            fprintf(to, "call $printf(l $fmt, ..., l %%s%d)\n", si - 1);
+            si--;
+            break;
+        case TOK_DUP:
+            fprintf(to, "%%s%d =l copy %%s%d\n", si, si - 1);
+            si++;
+            break;
+        case TOK_DROP:
+            si--;
+            break;
+        case TOK_NUM_INTU:
+            fprintf(to, "%%s%d =l copy %" PRIu64 "\n", si, it.tok_num.unsignd);
+            si++;
+            break;
+        case TOK_NUM_INT:
+            fprintf(to, "%%s%d =l copy %" PRId64 "\n", si, it.tok_num.signd);
+            si++;
+            break;
+        default:
+            return 1;
+        }
+    }
+    fprintf(to, "\n\tret 0\n}\n");
+    return 0;
+}
+
+/* A long straight-line program that keeps the stack a few deep. */
+static uint8_t *make_input(size_t *len)
+{
+    static const char *const binops[] = { "+ ", "- ", "* ", "/ " };
+    LIST(uint8_t) buf = { 0 };
+    uint64_t x = 0x243f6a8885a308d3ull;
+    int depth = 0;
+    for(size_t i = 0; i < OPS; i++) {
+        char tmp[32];
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        int n;
+        if(depth < 2 || (depth < 48 && x % 3 == 0)) {
+            n = snprintf(tmp, sizeof(tmp), "%" PRIu64 " ", x >> (x & 63));
+            depth++;
+        } else if(x % 7 == 1) {
+            n = snprintf(tmp, sizeof(tmp), "dup ");
+            depth++;
+        } else if(x % 11 == 1) {
+            n = snprintf(tmp, sizeof(tmp), "dump\n");
+            depth--;
+        } else {
+            n = snprintf(tmp, sizeof(tmp), "%s", binops[(x >> 8) & 3]);
+            depth--;
+        }
+        list_resize(&buf, buf.size + (size_t)n);
+        memcpy(buf.elems + buf.size, tmp, (size_t)n);
+        buf.size += (size_t)n;
+    }
+    *len = buf.size;
+    return buf.elems;
+}
+
+/* Contents of file `path`, NUL-terminated, length in `*len`. */
+static char *slurp(const char *path, size_t *len)
+{
+    FILE *f = fopen(path, "rb");
+    fseek(f, 0, SEEK_END);
+    *len = (size_t)ftell(f);
+    rewind(f);
+    char *s = zalloc(*len + 1);
+    *len = fread(s, 1, *len, f);
+    fclose(f);
+    return s;
+}
+
+static size_t count_lines(const char *s, size_t len)
+{
+    size_t n = 0;
+    for(size_t i = 0; i < len; i++) {
+        n += s[i] == '\n';
+    }
+    return n;
+}
+
+int main(void)
+{
+    const char *old_path = "/tmp/stac_bench_cg_old.ssa";
+    const char *new_path = "/tmp/stac_bench_cg_new.ssa";
+
+    size_t len;
+    uint8_t *in = make_input(&len);
+    lex_t *l = lex_create();
+    lex_supply_src(l, in, len);
+    lex_supply_name(l, "<bench>");
+    lex_do(l);
+
+    double best_old = 0, best_fd = 0, best_map = 0;
+    for(int r = 0; r < ROUNDS; r++) {
+        double t = bench_now();
+        FILE *f = fopen(old_path, "w");
+        cg_emit_fprintf(l, f);
+        fclose(f);
+        t = bench_now() - t;
+        best_old = r == 0 || t < best_old ? t : best_old;
+
+        t = bench_now();
+        int fd = open(new_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        emit_t e;
+        emit_init_fd(&e, fd);
+        cg_emit(l, &e);
+        emit_close(&e);
+        close(fd);
+        t = bench_now() - t;
+        best_fd = r == 0 || t < best_fd ? t : best_fd;
+
+        t = bench_now();
+        emit_open_mapped(&e, new_path);
+        cg_emit(l, &e);
+        emit_close(&e);
+        t = bench_now() - t;
+        best_map = r == 0 || t < best_map ? t : best_map;
+    }
+
+    /* the old generator names registers by stack depth and copies for
+     * `dup`, so the outputs differ; count instructions for each */
+    size_t old_len, new_len;
+    char *old = slurp(old_path, &old_len);
+    char *new = slurp(new_path, &new_len);
+    double old_insts = (double)count_lines(old, old_len);
+    double new_insts = (double)count_lines(new, new_len);
+    printf("%zu tokens; fprintf: %.0f lines, %zu bytes; emit: %.0f lines, "
+           "%zu bytes\n",
+           l->toks.size, old_insts, old_len, new_insts, new_len);
+
+    /* per token, so both sides do the same amount of work */
+    double toks = (double)l->toks.size;
+    bench_report("fprintf", toks, "tok", best_old);
+    bench_report("emit, write(2)", toks, "tok", best_fd);
+    bench_report("emit, mmap", toks, "tok", best_map);
+
+    unlink(old_path);
+    unlink(new_path);
+    free(old);
+    free(new);
+    lex_delete(l);
+    free(in);
+    return 0;
+}
@@ -0,0 +1,168 @@
+/*
+ * Copyright (C) 2025 therealblue24.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Incremental lexing benchmark: lex_edit vs. lexing everything again.
+ */
+#include "bench.h"
+#include "lex.h"
+
+#define TARGET (4u << 20) /* input size */
+
+static const char *const pieces[] = {
+    "34 35 + dump\n",
+    "func main int ptr -> int do\n",
+    "    0 ret\n",
+    "end\n",
+    "\"sigma \\x1\" drop\n",
+    "// a comment, 1 2 3\n",
+    "/* one\n   /* nested */ two\n */\n",
+    "3.25 -17 dup drop\n",
+};
+
+/* plain typing */
+static const char *const typing[] = {
+    "1", " ", "x", "\n", "42 ", "+",
+};
+
+/* edits that open or close a comment or string literal */
+static const char *const nesting[] = {
+    "/*", "*/", "\"", "//", "\n",
+};
+
+static LIST(uint8_t) buf;
+
+static uint64_t rng = 0x9e3779b97f4a7c15ull;
+
+static uint64_t next(void)
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 7;
+    rng ^= rng << 17;
+    return rng;
+}
+
+static void make_input(void)
+{
+    while(buf.size < TARGET) {
+        const char *p = pieces[next() % (sizeof(pieces) / sizeof(pieces[0]))];
+        size_t n = strlen(p);
+        list_resize(&buf, buf.size + n);
+        memcpy(buf.elems + buf.size, p, n);
+        buf.size += n;
+    }
+}
+
+/* Replace `del` bytes of `buf` at `off` with `ins`. */
+static void splice(size_t off, size_t del, const uint8_t *ins, size_t nins)
+{
+    size_t len = buf.size - del + nins;
+    list_resize(&buf, len);
+    memmove(buf.elems + off + nins, buf.elems + off + del,
+            buf.size - off - del);
+    memcpy(buf.elems + off, ins, nins);
+    buf.size = len;
+}
+
+/* Returns nonzero unless `a` and `b` hold the same tokens. String IDs
+ * are allowed to differ, the strings themselves aren't. */
+static int lex_cmp(const lex_t *a, const lex_t *b)
+{
+    if(a->toks.size != b->toks.size) {
+        return 1;
+    }
+    tokiter_t ia = { 0 }, ib = { 0 };
+    token_t x, y;
+    while(lex_iter(a, &ia, &x) && lex_iter(b, &ib, &y)) {
+        if(x.toktype != y.toktype || x.raw != y.raw || x.range != y.range) {
+            return 1;
+        }
+        if(x.langtype == TOKL_NUM && x.tok_num.unsignd != y.tok_num.unsignd) {
+            return 1;
+        }
+        if(x.langtype == TOKL_STRLIT &&
+           (x.tokl_strsz != y.tokl_strsz ||
+            memcmp(x.tokl_strlit, y.tokl_strlit, x.tokl_strsz))) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* Make `nedits` random edits from `typed` to `*lp`, comparing against
+ * a full `lex_do` every `check` edits. Reports the time per edit
+ * against `full`, the time a full lex took. */
+static void run_edits(const char *name, lex_t *l, const char *const *typed,
+                      size_t ntyped, int nedits, int check, double full)
+{
+    double secs = 0;
+    size_t bad = 0, failed = 0;
+    for(int e = 0; e < nedits; e++) {
+        /* replace a few bytes somewhere with something from `typed` */
+        const char *ins = typed[next() % ntyped];
+        size_t nins = strlen(ins);
+        size_t off = next() % buf.size;
+        size_t del = next() % 3;
+        del = del > buf.size - off ? buf.size - off : del;
+
+        uint8_t was[2];
+        memcpy(was, buf.elems + off, del);
+        splice(off, del, (const uint8_t *)ins, nins);
+
+        double t = bench_now();
+        int rc = lex_edit(l, buf.elems, buf.size, off, del, nins);
+        secs += bench_now() - t;
+
+        if(rc) {
+            /* e.g. an unterminated string literal, take it back */
+            failed++;
+            splice(off, nins, was, del);
+            rc = lex_edit(l, buf.elems, buf.size, off, nins, del);
+        }
+
+        if(rc || e % check == 0) {
+            lex_t *ref = lex_create();
+            lex_supply_src(ref, buf.elems, buf.size);
+            lex_supply_name(ref, "<bench>");
+            ref->quiet = true;
+            lex_do(ref);
+            bad += lex_cmp(l, ref) != 0;
+            lex_delete(ref);
+        }
+    }
+    if(bad) {
+        printf("%zu edits gave different tokens than lex_do!\n", bad);
+    }
+    size_t ok = (size_t)nedits - failed;
+    double per = secs / (double)ok;
+    printf("%-28s %12.1f us/edit, %.0fx faster than lex_do (%zu didn't lex)\n",
+           name, per * 1e6, full / per, failed);
+}
+
+int main(void)
+{
+    make_input();
+
+    lex_t *l = lex_create();
+    lex_supply_src(l, buf.elems, buf.size);
+    lex_supply_name(l, "<bench>");
+    l->quiet = true; /* some edits won't lex */
+    double t = bench_now();
+    lex_do(l);
+    double full = bench_now() - t;
+    printf("%zu bytes, %zu tokens\n", buf.size, l->toks.size);
+    bench_report("lex_do", (double)buf.size, "B", full);
+
+#define N(a) (sizeof(a) / sizeof(a[0]))
+    run_edits("lex_edit, typing", l, typing, N(typing), 4096, 64, full);
+    run_edits("lex_edit, comments/strings", l, nesting, N(nesting), 256, 1,
+              full);
+#undef N
+
+    lex_delete(l);
+    free(buf.elems);
+    return 0;
+}
@@ -0,0 +1,196 @@
+/*
+ * Copyright (C) 2025 therealblue24.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Fusion benchmark: the n-gram census the fusion table comes from, and
+ * the VM with and without fused ops.
+ *
+ * Usage: bench_fuse [corpus.stac...], the .stac files in test/ by
+ * default.
+ */
+#include "bench.h"
+#include "vm.h"
+#include <glob.h>
+
+#define OPS (1 << 20)
+#define ROUNDS 8
+#define TOP 10
+
+/* An n-gram of token kinds, and how often it showed up. */
+struct gram {
+    char s[48];
+    size_t n;
+};
+
+static LIST(struct gram) grams;
+
+/* Kind of token `tok`: the number itself doesn't matter. */
+static void kind(const token_t *tok, char *buf, size_t size)
+{
+    if(tok->toktype == TOK_NUM_INT || tok->toktype == TOK_NUM_INTU) {
+        snprintf(buf, size, "N");
+    } else {
+        snprintf(buf, size, "%.*s", (int)tok->range, tok->raw);
+    }
+}
+
+static void count(const char *s)
+{
+    for(size_t i = 0; i < grams.size; i++) {
+        if(strcmp(grams.elems[i].s, s) == 0) {
+            grams.elems[i].n++;
+            return;
+        }
+    }
+    struct gram g = { .n = 1 };
+    snprintf(g.s, sizeof(g.s), "%s", s);
+    list_append(&grams, g);
+}
+
+static int by_count(const void *a, const void *b)
+{
+    const struct gram *x = a, *y = b;
+    return x->n < y->n ? 1 : x->n > y->n ? -1 : strcmp(x->s, y->s);
+}
+
+/* Count the 2- and 3-grams of every file in `paths`. */
+static void census(char **paths, size_t npaths)
+{
+    size_t total = 0;
+    for(size_t f = 0; f < npaths; f++) {
+        FILE *fp = fopen(paths[f], "rb");
+        if(!fp) {
+            continue;
+        }
+        LIST(uint8_t) src = { 0 };
+        uint8_t chunk[4096];
+        size_t got;
+        while((got = fread(chunk, 1, sizeof(chunk), fp)) > 0) {
+            list_resize(&src, src.size + got);
+            memcpy(src.elems + src.size, chunk, got);
+            src.size += got;
+        }
+        fclose(fp);
+
+        lex_t *l = lex_create();
+        l->quiet = true;
+        lex_supply_src(l, src.elems, src.size);
+        lex_supply_name(l, paths[f]);
+        lex_do(l);
+        char k[3][16];
+        tokiter_t iter = { 0 };
+        token_t tok;
+        for(size_t i = 0; lex_iter(l, &iter, &tok); i++) {
+            memcpy(k[0], k[1], sizeof(k[0]));
+            memcpy(k[1], k[2], sizeof(k[0]));
+            kind(&tok, k[2], sizeof(k[2]));
+            char s[48];
+            if(i >= 1) {
+                snprintf(s, sizeof(s), "%s %s", k[1], k[2]);
+                count(s);
+                total++;
+            }
+            if(i >= 2) {
+                snprintf(s, sizeof(s), "%s %s %s", k[0], k[1], k[2]);
+                count(s);
+            }
+        }
+        lex_delete(l);
+        free(src.elems);
+    }
+
+    qsort(grams.elems, grams.size, sizeof(*grams.elems), by_count);
+    printf("census of %zu files, %zu bigrams:\n", npaths, total);
+    for(size_t i = 0; i < grams.size && i < TOP; i++) {
+        printf("  %5zu  %s\n", grams.elems[i].n, grams.elems[i].s);
+    }
+    free(grams.elems);
+}
+
+/* A long program made of the idioms the census finds, no output. */
+static uint8_t *make_input(size_t *len)
+{
+    static const char *const idioms[] = { "7 + ", "3 * ", "1 - ",
+                                          "dup 5 + drop ", "dup 2 * + ",
+                                          "dup drop ", "11 22 + + " };
+    LIST(uint8_t) buf = { 0 };
+    list_append_many(&buf, '1', ' ');
+    uint64_t x = 0x243f6a8885a308d3ull;
+    for(size_t i = 0; i < OPS / 3; i++) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        const char *s = idioms[x % (sizeof(idioms) / sizeof(idioms[0]))];
+        size_t n = strlen(s);
+        list_resize(&buf, buf.size + n);
+        memcpy(buf.elems + buf.size, s, n);
+        buf.size += n;
+    }
+    list_append_many(&buf, 'r', 'e', 't', '\n');
+    *len = buf.size;
+    return buf.elems;
+}
+
+int main(int argc, char **argv)
+{
+    glob_t g = { 0 };
+    char **paths = argv + 1;
+    size_t npaths = (size_t)argc - 1;
+    if(npaths == 0) {
+        glob("test/*.stac", 0, NULL, &g);
+        paths = g.gl_pathv;
+        npaths = g.gl_pathc;
+    }
+    census(paths, npaths);
+    globfree(&g);
+
+    size_t len;
+    uint8_t *in = make_input(&len);
+    lex_t *l = lex_create();
+    lex_supply_src(l, in, len);
+    lex_supply_name(l, "<bench>");
+    lex_do(l);
+
+    vmprog_t p[2];
+    vm_compile(&p[0], l, false);
+    vm_compile(&p[1], l, true);
+    printf("%zu tokens: %zu words unfused, %zu fused\n", l->toks.size,
+           p[0].code.size, p[1].code.size);
+    fuse_stats(&p[1].fused, "vm", stdout);
+
+    /* same work either way, so rate it per token */
+    double toks = (double)l->toks.size;
+    static const char *const names[2][2] = {
+        { "unfused, unchecked", "unfused, checked" },
+        { "fused, unchecked", "fused, checked" },
+    };
+    int64_t want = 0;
+    for(int f = 0; f < 2; f++) {
+        for(int c = 0; c < 2; c++) {
+            double best = 0;
+            int64_t got;
+            for(int r = 0; r < ROUNDS; r++) {
+                double t = bench_now();
+                vm_run(&p[f], l, c, &got);
+                t = bench_now() - t;
+                best = r == 0 || t < best ? t : best;
+            }
+            if(f + c == 0) {
+                want = got;
+            } else if(got != want) {
+                printf("mismatch: %" PRId64 " vs. %" PRId64 "\n", got, want);
+                return 1;
+            }
+            bench_report(names[f][c], toks, "tok", best);
+        }
+    }
+
+    vm_free(&p[0]);
+    vm_free(&p[1]);
+    lex_delete(l);
+    free(in);
+    return 0;
+}
@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2025 therealblue24.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * JIT benchmark: time from source text to the first instruction running.
+ */
+#include "bench.h"
+#include "jit.h"
+#include "opt.h"
+
+#define ROUNDS 50
+#define BIG_OPS (1 << 18)
+
+/* test/add.stac, without the dumps */
+static const char small[] = "34 35 +\ndup drop\n351 +\ndup drop\n"
+                            "42 10 * /\ndup drop\n1 -\ndup ret\n";
+
+/* A long straight-line program that keeps the stack a few deep and
+ * returns the top of it. */
+static uint8_t *make_input(size_t *len)
+{
+    static const char *const binops[] = { "+ ", "- ", "* ", "+ " };
+    LIST(uint8_t) buf = { 0 };
+    uint64_t x = 0x243f6a8885a308d3ull;
+    int depth = 0;
+    for(size_t i = 0; i < BIG_OPS; i++) {
+        char tmp[32];
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        int n;
+        if(depth < 2 || (depth < 48 && x % 3 == 0)) {
+            n = snprintf(tmp, sizeof(tmp), "%" PRIu64 " ", x >> (x & 63));
+            depth++;
+        } else if(x % 7 == 1) {
+            n = snprintf(tmp, sizeof(tmp), "dup ");
+            depth++;
+        } else {
+            n = snprintf(tmp, sizeof(tmp), "%s", binops[(x >> 8) & 3]);
+            depth--;
+        }
+        list_resize(&buf, buf.size + (size_t)n);
+        memcpy(buf.elems + buf.size, tmp, (size_t)n);
+        buf.size += (size_t)n;
+    }
+    list_append_many(&buf, 'r', 'e', 't', '\n');
+    *len = buf.size;
+    return buf.elems;
+}
+
+/* Best time of `rounds` runs from `src` to the program having run, in
+ * seconds. The JIT's own share of it goes in `*jit_secs`. */
+static double time_run(const uint8_t *src, size_t len, int olevel,
+                       int rounds, double *jit_secs, int64_t *ret)
+{
+    double best = 0, best_jit = 0;
+    for(int r = 0; r < rounds; r++) {
+        double t = bench_now();
+        lex_t *l = lex_create();
+        lex_supply_src(l, src, len);
+        lex_supply_name(l, "<bench>");
+        lex_do(l);
+        ir_t ir;
+        ir_build(&ir, l);
+        optstats_t st;
+        opt_run(&ir, olevel, &st);
+
+        double tj = bench_now();
+        jit_t j;
+        jit_compile(&j, &ir, l);
+        tj = bench_now() - tj;
+        *ret = jit_run(&j);
+        t = bench_now() - t;
+
+        jit_free(&j);
+        ir_free(&ir);
+        lex_delete(l);
+        best = r == 0 || t < best ? t : best;
+        best_jit = r == 0 || tj < best_jit ? tj : best_jit;
+    }
+    *jit_secs = best_jit;
+    return best;
+}
+
+int main(void)
+{
+    int64_t ret;
+    double tj;
+    double t = time_run((const uint8_t *)small, sizeof(small) - 1, 1, ROUNDS,
+                        &tj, &ret);
+    printf("small program (returned %" PRId64 "): %.1f us source to exit, "
+           "%.1f us in the JIT\n",
+           ret, t * 1e6, tj * 1e6);
+
+    size_t len;
+    uint8_t *big = make_input(&len);
+    /* -O0: it's all constants, -O1 would fold the whole thing away */
+    t = time_run(big, len, 0, 4, &tj, &ret);
+    printf("%d ops: %.2f ms source to exit, %.2f ms in the JIT\n", BIG_OPS,
+           t * 1e3, tj * 1e3);
+    bench_report("JIT", BIG_OPS, "op", tj);
+    free(big);
+    return 0;
+}
@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2025 therealblue24.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Keyword lookup benchmark: old linear scan vs. the perfect-hash table.
+ */
+#include "bench.h"
+#include "lex.h"
+
+/* the lexeme mix we look up, roughly what generated sources look like */
+static const char *words[] = {
+    "dup",     "42",     "+",          "some_function", "dump",
+    "1234567", "drop",   "\"a string\"", "uint64_t",     "x",
+    "*",       "ret",    "another_one",  "-",            "int",
+    "end",     "do",     "99",           "func",         "counter",
+};
+
+#define WORD_COUNT (sizeof(words) / sizeof(words[0]))
+#define ROUNDS     (4 * 1000 * 1000)
+
+/* The keyword list `lex_do` used to scan, as it was. */
+#define X(x)                                 \
+    { "int" xstr(x) "_t", TOK_INT##x##_T },  \
+    {                                        \
+        "uint" xstr(x) "_t", TOK_UINT##x##_T \
+    }
+
+static const struct {
+    const char *nam;
+    const size_t map;
+} keywords[] = {
+    { "+",         TOK_ADD       },
+    { "-",         TOK_SUB       },
+    { "*",         TOK_MUL       },
+    { "/",         TOK_DIV       },
+    { "dup",       TOK_DUP       },
+    { "drop",      TOK_DROP      },
+    { "dropall",   TOK_DROPALL   },
+    { "ret",       TOK_RET       },
+    { "dump",      TOK_DUMP      },
+    { "do",        TOK_DO        },
+    { "end",       TOK_END       },
+    { "func",      TOK_FUNC      },
+    { "->",        TOK_ARROW     },
+    { "char",      TOK_CHAR      },
+    { "uchar",     TOK_UCHAR     },
+    { "short",     TOK_SHORT     },
+    { "ushort",    TOK_USHORT    },
+    { "int",       TOK_INT       },
+    { "uint",      TOK_UINT      },
+    { "long",      TOK_LONG      },
+    { "ulong",     TOK_ULONG     },
+    { "str",       TOK_STR       },
+    { "ptr",       TOK_PTR       },
+    { "none",      TOK_NONE      },
+    { "size_t",    TOK_SIZE_T    },
+    { "intmax_t",  TOK_INTMAX_T  },
+    { "uintmax_t", TOK_UINTMAX_T },
+    X(8),
+    X(16),
+    X(32),
+    X(64)
+};
+
+#undef X
+
+static const size_t keyword_count = sizeof(keywords) / sizeof(keywords[0]);
+
+/* What `lex_do` used to do for every view. */
+static int lookup_linear(const uint8_t *src, size_t len)
+{
+    for(size_t j = 0; j < keyword_count; j++) {
+        if(len == strnlen(keywords[j].nam, 100) &&
+           strncmp((const char *)src, keywords[j].nam, len) == 0) {
+            return (int)keywords[j].map;
+        }
+    }
+    return -1;
+}
+
+static void bench_lookup(void)
+{
+    size_t lens[WORD_COUNT];
+    for(size_t i = 0; i < WORD_COUNT; i++) {
+        lens[i] = strlen(words[i]);
+    }
+
+    double t = bench_now();
+    for(size_t r = 0; r < ROUNDS; r++) {
+        size_t i = r % WORD_COUNT;
+        bench_use(lookup_linear((const uint8_t *)words[i], lens[i]));
+    }
+    bench_report("lookup (linear, before)", ROUNDS, "tok", bench_now() - t);
+
+    t = bench_now();
+    for(size_t r = 0; r < ROUNDS; r++) {
+        size_t i = r % WORD_COUNT;
+        bench_use(lex_lookup_keyword((const uint8_t *)words[i], lens[i]));
+    }
+    bench_report("lookup (perfect hash, after)", ROUNDS, "tok",
+                 bench_now() - t);
+}
+
+static void bench_lex(void)
+{
+    /* build a big source out of the word mix */
+    LIST(uint8_t) src = { 0 };
+    size_t ntoks = 0;
+    while(src.size < (16 << 20)) {
+        const char *w = words[ntoks++ % WORD_COUNT];
+        for(const char *c = w; *c; c++) {
+            list_append(&src, (uint8_t)*c);
+        }
+        list_append(&src, (ntoks % 12) ? ' ' : '\n');
+    }
+
+    lex_t *l = lex_create();
+    lex_supply_src(l, src.elems, src.size);
+    lex_supply_name(l, "<bench>");
+    double t = bench_now();
+    if(lex_do(l)) {
+        fprintf(stderr, "lex_do failed\n");
+        exit(EXIT_FAILURE);
+    }
+    bench_report("lex_do", (double)l->toks.size, "tok", bench_now() - t);
+    lex_delete(l);
+    free(src.elems);
+}
+
+int main(void)
+{
+    bench_lookup();
+    bench_lex();
+    return 0;
+}
@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2025 therealblue24.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Loop benchmark: stac loops through the JIT against the same loops in
+ * C, built with the benchmarks (RELEASE=yes for -O2). The loop-carried
+ * stack stays in registers, so the JIT should be within 1.5x of C.
+ *
+ * The loops are LCGs, which nothing folds into a closed form. One has
+ * its step in a function, which -O inlines: it should run as fast as
+ * the plain one, and -O0 shows what the call costs.
+ */
+#include "bench.h"
+#include "jit.h"
+#include "opt.h"
+
+#define ITERS (1 << 26)
+#define ROUNDS 3
+
+/* MMIX's LCG */
+#define MUL 6364136223846793005ull
+#define INC 1442695040888963407ull
+
+/* The loops in C, `n` times from `x`. */
+static int64_t c_lcg(uint64_t x, int64_t n)
+{
+    for(; n > 0; n--) {
+        x = x * MUL + INC;
+    }
+    return (int64_t)x;
+}
+
+static int64_t c_branchy(uint64_t x, int64_t n)
+{
+    for(; n > 0; n--) {
+        x = x * MUL + INC;
+        if((int64_t)x < 0) {
+            x += 12345;
+        }
+    }
+    return (int64_t)x;
+}
+
+/* The same in stac, `%d` iterations from 7: the stack is `x n`. */
+static const struct {
+    const char *name;
+    const char *src;
+    int64_t (*c)(uint64_t x, int64_t n);
+    int olevel;
+} loops[] = {
+    { "lcg",
+      "7 %d while dup 0 < do swap 6364136223846793005 * "
+      "1442695040888963407 + swap -1 + end drop ret\n",
+      c_lcg, 1 },
+    { "lcg, branch in the loop",
+      "7 %d while dup 0 < do swap 6364136223846793005 * "
+      "1442695040888963407 + if dup 0 > then 12345 + end swap -1 + end "
+      "drop ret\n",
+      c_branchy, 1 },
+#define STEP                                                               \
+    "func step long -> long do 6364136223846793005 * 1442695040888963407 " \
+    "+ end\n"
+    { "lcg, step in a function (-O, inlined)",
+      STEP "7 %d while dup 0 < do swap step swap -1 + end drop ret\n", c_lcg,
+      1 },
+    { "lcg, step in a function (-O0, called)",
+      STEP "7 %d while dup 0 < do swap step swap -1 + end drop ret\n", c_lcg,
+      0 },
+#undef STEP
+};
+
+int main(void)
+{
+    /* keep the compiler from knowing how many iterations there are */
+    volatile int64_t iters = ITERS;
+    for(size_t k = 0; k < sizeof(loops) / sizeof(loops[0]); k++) {
+        char src[256];
+        int len = snprintf(src, sizeof(src), loops[k].src, (int)iters);
+        lex_t *l = lex_create();
+        lex_supply_src(l, (const uint8_t *)src, (size_t)len);
+        lex_supply_name(l, "<bench>");
+        lex_do(l);
+        ir_t ir;
+        jit_t j;
+        optstats_t st;
+        if(ir_build(&ir, l)) {
+            return 1;
+        }
+        opt_run(&ir, loops[k].olevel, &st);
+        if(jit_compile(&j, &ir, l)) {
+            return 1;
+        }
+
+        double best[2] = { 0 };
+        int64_t got = 0, want = 0;
+        for(int r = 0; r < ROUNDS; r++) {
+            double t = bench_now();
+            got = jit_run(&j);
+            t = bench_now() - t;
+            best[0] = r == 0 || t < best[0] ? t : best[0];
+
+            t = bench_now();
+            want = loops[k].c(7, iters);
+            t = bench_now() - t;
+            best[1] = r == 0 || t < best[1] ? t : best[1];
+        }
+        if(got != want) {
+            printf("%s: mismatch: %" PRId64 " vs. %" PRId64 "\n",
+                   loops[k].name, got, want);
+            return 1;
+        }
+
+        printf("%s:\n", loops[k].name);
+        bench_report("  stac (JIT)", (double)iters, "iter", best[0]);
+        bench_report("  C", (double)iters, "iter", best[1]);
+        printf("  %.2fx C's time\n", best[0] / best[1]);
+
+        jit_free(&j);
+        ir_free(&ir);
+        lex_delete(l);
+    }
+    return 0;
+}
@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2025 therealblue24.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Numeral parsing benchmark: num_parse vs. strtoull and strtod.
+ */
+#include "bench.h"
+#include "lex.h"
+#include "num.h"
+
+#define COUNT (1 << 20)
+#define ROUNDS 8
+
+/* `COUNT` NUL-separated numerals */
+static char *make_input(bool floats, size_t *offs)
+{
+    LIST(char) buf = { 0 };
+    uint64_t x = 0x243f6a8885a308d3ull;
+    for(size_t i = 0; i < COUNT; i++) {
+        char tmp[64];
+        /* xorshift, mix of short and long numbers */
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        uint64_t v = x >> (x & 63);
+        int n;
+        if(floats) {
+            n = snprintf(tmp, sizeof(tmp), "%" PRIu64 ".%u", v % 1000000,
+                         (unsigned)(x >> 40) % 1000);
+        } else {
+            n = snprintf(tmp, sizeof(tmp), "%" PRIu64, v);
+        }
+        offs[i] = buf.size;
+        list_resize(&buf, buf.size + (size_t)n + 1);
+        memcpy(buf.elems + buf.size, tmp, (size_t)n + 1);
+        buf.size += (size_t)n + 1;
+    }
+    return buf.elems;
+}
+
+static void bench_kind(bool floats)
+{
+    size_t *offs = zcalloc(COUNT, sizeof(*offs));
+    size_t *lens = zcalloc(COUNT, sizeof(*lens));
+    char *in = make_input(floats, offs);
+    for(size_t i = 0; i < COUNT; i++) {
+        lens[i] = strlen(in + offs[i]);
+    }
+
+    /* results have to agree before the timings mean anything */
+    size_t bad = 0;
+    for(size_t i = 0; i < COUNT; i++) {
+        num_t n;
+        const char *s = in + offs[i];
+        if(num_parse((const uint8_t *)s, lens[i], &n) != NUM_OK) {
+            bad++;
+        } else if(floats ? n.fltd != strtod(s, NULL)
+                         : n.unsignd != strtoull(s, NULL, 10)) {
+            bad++;
+        }
+    }
+    if(bad) {
+        printf("%zu mismatches!\n", bad);
+    }
+
+    double t = bench_now();
+    for(int r = 0; r < ROUNDS; r++) {
+        for(size_t i = 0; i < COUNT; i++) {
+            if(floats) {
+                bench_use(strtod(in + offs[i], NULL));
+            } else {
+                bench_use(strtoull(in + offs[i], NULL, 10));
+            }
+        }
+    }
+    bench_report(floats ? "strtod" : "strtoull", (double)COUNT * ROUNDS,
+                 "num", bench_now() - t);
+
+    t = bench_now();
+    for(int r = 0; r < ROUNDS; r++) {
+        for(size_t i = 0; i < COUNT; i++) {
+            num_t n;
+            num_parse((const uint8_t *)in + offs[i], lens[i], &n);
+            bench_use(n.unsignd);
+        }
+    }
+    bench_report(floats ? "num_parse (float)" : "num_parse (int)",
+                 (double)COUNT * ROUNDS, "num", bench_now() - t);
+
+    free(in);
+    free(offs);
+    free(lens);
+}
+
+int main(void)
+{
+    bench_kind(false);
+    bench_kind(true);
+    return 0;
+}
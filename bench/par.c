@@ -0,0 +1,124 @@
+/*
+ * Copyright (C) 2025 therealblue24.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Parallel lexing benchmark: lex_do vs. lex_do_parallel on 1..N threads.
+ */
+#include "bench.h"
+#include "lex.h"
+#include <unistd.h>
+
+#define TARGET (64u << 20) /* input size */
+#define ROUNDS 3
+
+/* Roughly `TARGET` bytes of code, with multi-line comments and strings
+ * that straddle lines so chunk guesses go wrong now and then. */
+static uint8_t *make_input(size_t *len)
+{
+    static const char *const pieces[] = {
+        "34 35 + dump\n",
+        "func main int ptr -> int do\n",
+        "    0 ret\n",
+        "end\n",
+        "\"sigma \\x1 \\u00e9\" drop\n",
+        "// a comment, 1 2 3\n",
+        "/* one\n   two\n  /* nested\n    three */\n 4 5 */\n",
+        "/*\n\"not a string\n*/ 42 10 * /\n",
+        "3.25 -17 18446744073709551615 dup drop\n",
+        "\"string\n/* not a comment\" dup\n",
+    };
+    LIST(uint8_t) buf = { 0 };
+    uint64_t x = 0x9e3779b97f4a7c15ull;
+    while(buf.size < TARGET) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        const char *p = pieces[x % (sizeof(pieces) / sizeof(pieces[0]))];
+        size_t n = strlen(p);
+        list_resize(&buf, buf.size + n);
+        memcpy(buf.elems + buf.size, p, n);
+        buf.size += n;
+    }
+    *len = buf.size;
+    return buf.elems;
+}
+
+static lex_t *lex_run(const uint8_t *in, size_t len, int nthreads,
+                      double *secs)
+{
+    lex_t *l = lex_create();
+    lex_supply_src(l, in, len);
+    lex_supply_name(l, "<bench>");
+    double t = bench_now();
+    if(lex_do_parallel(l, nthreads)) {
+        printf("lexing failed!\n");
+    }
+    *secs = bench_now() - t;
+    return l;
+}
+
+/* Returns nonzero unless `a` and `b` hold the very same tokens. */
+static int lex_cmp(const lex_t *a, const lex_t *b)
+{
+    const tokstore_t *x = &a->toks, *y = &b->toks;
+    if(x->size != y->size || x->payload.size != y->payload.size) {
+        return 1;
+    }
+    if(memcmp(x->type, y->type, x->size) ||
+       memcmp(x->start, y->start, x->size * sizeof(*x->start)) ||
+       memcmp(x->len, y->len, x->size * sizeof(*x->len))) {
+        return 1;
+    }
+    for(size_t i = 0; i < x->payload.size; i++) {
+        const tokpayload_t *p = &x->payload.elems[i];
+        const tokpayload_t *q = &y->payload.elems[i];
+        if(p->tok != q->tok) {
+            return 1;
+        }
+        if(x->type[p->tok] == TOK_SPECIAL_STRLIT) {
+            if(p->strlit.id != q->strlit.id ||
+               p->strlit.size != q->strlit.size ||
+               memcmp(p->strlit.str, q->strlit.str, p->strlit.size)) {
+                return 1;
+            }
+        } else if(memcmp(&p->num, &q->num, sizeof(p->num))) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* usage: bench_par [max threads], defaults to the number of cpus */
+int main(int argc, char *argv[])
+{
+    size_t len;
+    uint8_t *in = make_input(&len);
+    int ncpu = argc > 1 ? atoi(argv[1]) : (int)sysconf(_SC_NPROCESSORS_ONLN);
+    ncpu = ncpu < 1 ? 1 : ncpu;
+
+    double secs;
+    lex_t *ref = lex_run(in, len, 1, &secs);
+    printf("%zu bytes, %zu tokens, up to %d threads\n", len, ref->toks.size, ncpu);
+
+    for(int n = 1; n <= ncpu; n *= 2) {
+        double best = 0;
+        for(int r = 0; r < ROUNDS; r++) {
+            lex_t *l = lex_run(in, len, n, &secs);
+            if(lex_cmp(ref, l)) {
+                printf("%d threads: tokens differ from lex_do!\n", n);
+            }
+            lex_delete(l);
+            best = r == 0 || secs < best ? secs : best;
+        }
+        char name[32];
+        snprintf(name, sizeof(name), "lex_do_parallel -j%d", n);
+        bench_report(name, (double)len, "B", best);
+    }
+
+    lex_delete(ref);
+    free(in);
+    return 0;
+}
@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 2025 therealblue24.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Pruning benchmark: a large generated program where most functions are
+ * never called and every one has code after its `ret`, against the same
+ * program with all of that left out by hand. With what can't run gone
+ * from the IR, both should come out the same size and take as long to
+ * compile; so should running qbe on them, if it's on the PATH.
+ */
+#include "bench.h"
+#include "cg.h"
+#include <fcntl.h>
+#include <unistd.h>
+
+#define FUNCS 4096
+#define BODY 64 /* `dup 3 * +`s per function */
+#define LIVE 4 /* one in this many functions gets called */
+#define ROUNDS 4
+
+typedef LIST(char) text_t;
+
+/* Append `s` to `buf`. */
+static void put(text_t *buf, const char *s)
+{
+    size_t n = strlen(s);
+    list_resize(buf, buf->size + n);
+    memcpy(buf->elems + buf->size, s, n);
+    buf->size += n;
+}
+
+/* The program, with the dead parts if `dead`. Live functions call the
+ * live one before them, dead ones the one right before. */
+static char *make_input(bool dead, size_t *len)
+{
+    text_t buf = { 0 };
+    char tmp[64];
+    for(int k = 0; k < FUNCS; k++) {
+        bool live = k % LIVE == 0;
+        if(!live && !dead) {
+            continue;
+        }
+        snprintf(tmp, sizeof(tmp), "func f%d long -> long do\n", k);
+        put(&buf, tmp);
+        for(int j = 0; j < BODY; j++) {
+            put(&buf, "dup 3 * + ");
+        }
+        int callee = live ? k - LIVE : k - 1;
+        if(callee >= 0) {
+            snprintf(tmp, sizeof(tmp), "f%d ", callee);
+            put(&buf, tmp);
+        }
+        put(&buf, "ret\n");
+        for(int j = 0; dead && j < BODY; j++) {
+            put(&buf, "7 dup * dump ");
+        }
+        put(&buf, "end\n");
+    }
+    snprintf(tmp, sizeof(tmp), "1 f%d dump 0 ret\n", FUNCS - LIVE);
+    put(&buf, tmp);
+    *len = buf.size;
+    return buf.elems;
+}
+
+/* Compile `src` to QBE in `path`. Returns the time it took, negative
+ * on failure. */
+static double compile(const char *src, size_t len, const char *path)
+{
+    double t = bench_now();
+    lex_t *l = lex_create();
+    lex_supply_src(l, (const uint8_t *)src, len);
+    lex_supply_name(l, "<bench>");
+    lex_do(l);
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    emit_t e;
+    emit_init_fd(&e, fd);
+    int r = cg_emit(l, &e);
+    emit_close(&e);
+    close(fd);
+    lex_delete(l);
+    return r ? -1 : bench_now() - t;
+}
+
+/* Size of file `path`, and its lines in `*lines`. */
+static size_t file_size(const char *path, size_t *lines)
+{
+    FILE *f = fopen(path, "rb");
+    size_t n = 0;
+    int c;
+    *lines = 0;
+    while((c = getc(f)) != EOF) {
+        *lines += c == '\n';
+        n++;
+    }
+    fclose(f);
+    return n;
+}
+
+int main(void)
+{
+    static const char *const paths[2] = { "/tmp/stac_bench_prune_full.ssa",
+                                          "/tmp/stac_bench_prune_trim.ssa" };
+    static const char *const names[2] = { "with dead code", "without" };
+    bool qbe = system("command -v qbe >/dev/null 2>&1") == 0;
+
+    for(int v = 0; v < 2; v++) {
+        size_t len;
+        char *src = make_input(v == 0, &len);
+        double best = 0, best_qbe = 0;
+        for(int r = 0; r < ROUNDS; r++) {
+            double t = compile(src, len, paths[v]);
+            if(t < 0) {
+                printf("%s: failed to compile\n", names[v]);
+                return 1;
+            }
+            best = r == 0 || t < best ? t : best;
+            if(qbe) {
+                char cmd[128];
+                snprintf(cmd, sizeof(cmd), "qbe -o /dev/null %s", paths[v]);
+                t = bench_now();
+                if(system(cmd) != 0) {
+                    printf("%s: qbe failed\n", names[v]);
+                    return 1;
+                }
+                t = bench_now() - t;
+                best_qbe = r == 0 || t < best_qbe ? t : best_qbe;
+            }
+        }
+        /* registers are numbered before pruning, so the names of the
+         * same ones can be longer with dead code around */
+        size_t lines, size = file_size(paths[v], &lines);
+        printf("%s: %zu bytes in, %zu lines (%zu bytes) of QBE out\n",
+               names[v], len, lines, size);
+        bench_report("  stac", (double)len, "B", best);
+        if(qbe) {
+            bench_report("  qbe", (double)len, "B", best_qbe);
+        }
+        unlink(paths[v]);
+        free(src);
+    }
+    return 0;
+}
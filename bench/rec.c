@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2025 therealblue24.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Recursion benchmark: stac functions that recurse in tail position,
+ * through the JIT, against the same loops in C. Tail calls of the
+ * function itself become a loop and the others jumps, so none of them
+ * grow the stack: at this depth they'd run out of it otherwise.
+ */
+#include "bench.h"
+#include "jit.h"
+#include "opt.h"
+
+#define DEPTH (1 << 26)
+#define ROUNDS 3
+
+/* MMIX's LCG, as in loop.c */
+#define MUL "6364136223846793005"
+#define INC "1442695040888963407"
+
+/* The loops in C, `n` times from `x`. */
+static int64_t c_down(uint64_t x, int64_t n)
+{
+    (void)x;
+    for(; n > 0; n--) {
+        bench_use(n);
+    }
+    return n;
+}
+
+static int64_t c_lcg(uint64_t x, int64_t n)
+{
+    for(; n > 0; n--) {
+        x = x * 6364136223846793005ull + 1442695040888963407ull;
+    }
+    return (int64_t)x;
+}
+
+/* The same in stac, recursing `%d` times. */
+static const struct {
+    const char *name;
+    const char *src;
+    int64_t (*c)(uint64_t x, int64_t n);
+} recs[] = {
+    { "countdown",
+      "func down long -> long do if dup 0 < then -1 + down end end\n"
+      "%d down ret\n",
+      c_down },
+    { "accumulator",
+      "func acc long long -> long do if dup 0 < then swap " MUL " * " INC
+      " + swap -1 + acc else drop end end\n"
+      "7 %d acc ret\n",
+      c_lcg },
+    { "accumulator, mutual",
+      "func ping long long -> long do if dup 0 < then swap " MUL " * " INC
+      " + swap -1 + pong else drop end end\n"
+      "func pong long long -> long do if dup 0 < then swap " MUL " * " INC
+      " + swap -1 + ping else drop end end\n"
+      "7 %d ping ret\n",
+      c_lcg },
+};
+
+int main(void)
+{
+    /* keep the compiler from knowing how deep it goes */
+    volatile int64_t depth = DEPTH;
+    for(size_t k = 0; k < sizeof(recs) / sizeof(recs[0]); k++) {
+        char src[512];
+        int len = snprintf(src, sizeof(src), recs[k].src, (int)depth);
+        lex_t *l = lex_create();
+        lex_supply_src(l, (const uint8_t *)src, (size_t)len);
+        lex_supply_name(l, "<bench>");
+        lex_do(l);
+        ir_t ir;
+        jit_t j;
+        optstats_t st;
+        if(ir_build(&ir, l)) {
+            return 1;
+        }
+        opt_run(&ir, 1, &st);
+        if(jit_compile(&j, &ir, l)) {
+            return 1;
+        }
+
+        double best[2] = { 0 };
+        int64_t got = 0, want = 0;
+        for(int r = 0; r < ROUNDS; r++) {
+            double t = bench_now();
+            got = jit_run(&j);
+            t = bench_now() - t;
+            best[0] = r == 0 || t < best[0] ? t : best[0];
+
+            t = bench_now();
+            want = recs[k].c(7, depth);
+            t = bench_now() - t;
+            best[1] = r == 0 || t < best[1] ? t : best[1];
+        }
+        if(got != want) {
+            printf("%s: mismatch: %" PRId64 " vs. %" PRId64 "\n",
+                   recs[k].name, got, want);
+            return 1;
+        }
+
+        printf("%s:\n", recs[k].name);
+        bench_report("  stac (JIT)", (double)depth, "call", best[0]);
+        bench_report("  C", (double)depth, "iter", best[1]);
+        printf("  %.2fx C's time\n", best[0] / best[1]);
+
+        jit_free(&j);
+        ir_free(&ir);
+        lex_delete(l);
+    }
+    return 0;
+}
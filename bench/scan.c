@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2025 therealblue24.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Scanner benchmark: comment- and string-heavy input, per implementation.
+ */
+#include "bench.h"
+#include "lex.h"
+#include "scan.h"
+
+#define INPUT_SIZE (64 << 20)
+
+static const char *pieces[] = {
+    "/* a fairly long block comment that goes on and on, describing\n"
+    "   what the next few lines do /* with a nested one */ and more */\n",
+    "\"a long string literal with an \\\"escape\\\" in the middle of it\" ",
+    "// a line comment that runs all the way to the end of the line\n",
+    "dup 42 + dump\n",
+};
+
+#define PIECE_COUNT (sizeof(pieces) / sizeof(pieces[0]))
+
+static const enum scan_isa isas[] = { SCAN_SCALAR, SCAN_SSE2, SCAN_AVX2 };
+
+int main(void)
+{
+    LIST(uint8_t) src = { 0 };
+    for(size_t i = 0; src.size < INPUT_SIZE; i++) {
+        const char *p = pieces[i % PIECE_COUNT];
+        size_t n = strlen(p);
+        list_resize(&src, src.size + n);
+        memcpy(src.elems + src.size, p, n);
+        src.size += n;
+    }
+
+    for(size_t i = 0; i < sizeof(isas) / sizeof(isas[0]); i++) {
+        enum scan_isa got = scan_select(isas[i]);
+        if(got != isas[i]) {
+            printf("%-8s unsupported, skipped\n", scan_isa_name(isas[i]));
+            continue;
+        }
+
+        /* the raw kernel, walking every comment byte of interest */
+        double t = bench_now();
+        size_t hits = 0;
+        for(size_t p = 0; p < src.size; p++, hits++) {
+            p = scan_comment(src.elems, p, src.size);
+        }
+        bench_use(hits);
+        char nam[64];
+        snprintf(nam, sizeof(nam), "scan_comment (%s)", scan_isa_name(got));
+        bench_report(nam, (double)src.size, "B", bench_now() - t);
+
+        /* the whole lexer */
+        lex_t *l = lex_create();
+        lex_supply_src(l, src.elems, src.size);
+        t = bench_now();
+        if(lex_do(l)) {
+            fprintf(stderr, "lex_do failed\n");
+            return 1;
+        }
+        snprintf(nam, sizeof(nam), "lex_do (%s)", scan_isa_name(got));
+        bench_report(nam, (double)src.size, "B", bench_now() - t);
+        lex_delete(l);
+    }
+
+    free(src.elems);
+    return 0;
+}
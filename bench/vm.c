@@ -0,0 +1,137 @@
+/*
+ * Copyright (C) 2025 therealblue24.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * VM benchmark: dispatch cost per op, threaded checked and unchecked vs.
+ * a plain switch over the same bytecode.
+ */
+#include "bench.h"
+#include "vm.h"
+
+#define OPS (1 << 20)
+#define ROUNDS 8
+
+/* A long straight-line program that keeps the stack a few deep, no
+ * output, so it's all dispatch and arithmetic. */
+static uint8_t *make_input(size_t *len)
+{
+    static const char *const ops[] = { "+ ", "- ", "* ", "dup ", "drop " };
+    LIST(uint8_t) buf = { 0 };
+    uint64_t x = 0x243f6a8885a308d3ull;
+    int depth = 0;
+    for(size_t i = 0; i < OPS; i++) {
+        char tmp[32];
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        int n;
+        if(depth < 2 || (depth < 16 && x % 3 == 0)) {
+            n = snprintf(tmp, sizeof(tmp), "%" PRIu64 " ", x & 0xffff);
+            depth++;
+        } else {
+            int op = (int)((x >> 8) % 5);
+            n = snprintf(tmp, sizeof(tmp), "%s", ops[op]);
+            depth += op == 3 ? 1 : -1;
+        }
+        list_resize(&buf, buf.size + (size_t)n);
+        memcpy(buf.elems + buf.size, tmp, (size_t)n);
+        buf.size += (size_t)n;
+    }
+    list_append_many(&buf, 'r', 'e', 't', '\n');
+    *len = buf.size;
+    return buf.elems;
+}
+
+/* The same bytecode, one switch per op and the whole stack in memory. */
+static int64_t run_switch(const vmprog_t *p, int64_t *stack)
+{
+    const vmword_t *pc = p->code.elems;
+    int64_t *sp = stack;
+    for(;;) {
+        switch((pc++)->op) {
+        case VM_PUSH:
+            *sp++ = (pc++)->imm;
+            break;
+        case VM_ADD:
+            sp--;
+            sp[-1] = (int64_t)((uint64_t)sp[0] + (uint64_t)sp[-1]);
+            break;
+        case VM_SUB:
+            sp--;
+            sp[-1] = (int64_t)((uint64_t)sp[0] - (uint64_t)sp[-1]);
+            break;
+        case VM_MUL:
+            sp--;
+            sp[-1] = (int64_t)((uint64_t)sp[0] * (uint64_t)sp[-1]);
+            break;
+        case VM_DUP:
+            sp[0] = sp[-1];
+            sp++;
+            break;
+        case VM_DROP:
+            sp--;
+            break;
+        case VM_RET:
+            return sp[-1];
+        default:
+            return 0;
+        }
+    }
+}
+
+int main(void)
+{
+    size_t len;
+    uint8_t *in = make_input(&len);
+    lex_t *l = lex_create();
+    lex_supply_src(l, in, len);
+    lex_supply_name(l, "<bench>");
+    lex_do(l);
+
+    vmprog_t p;
+    /* unfused, so the switch below knows every op */
+    if(vm_compile(&p, l, false)) {
+        return 1;
+    }
+    /* every op word is one dispatch */
+    double ops = (double)l->toks.size + 1;
+    printf("%zu ops, %zu words, %" PRIu32 " deep\n", l->toks.size,
+           p.code.size, p.maxdepth);
+
+    int64_t *stack = zcalloc((size_t)p.maxdepth + 1, sizeof(*stack));
+    int64_t want = run_switch(&p, stack), got;
+    double best[3] = { 0 };
+    for(int r = 0; r < ROUNDS; r++) {
+        double t = bench_now();
+        bench_use(run_switch(&p, stack));
+        t = bench_now() - t;
+        best[0] = r == 0 || t < best[0] ? t : best[0];
+
+        for(int m = 0; m < 2; m++) {
+            t = bench_now();
+            vm_run(&p, l, m == 0, &got);
+            t = bench_now() - t;
+            if(got != want) {
+                printf("mismatch: %" PRId64 " vs. %" PRId64 "\n", got, want);
+                return 1;
+            }
+            best[m + 1] = r == 0 || t < best[m + 1] ? t : best[m + 1];
+        }
+    }
+
+    static const char *const names[] = { "switch", "threaded, checked",
+                                          "threaded, unchecked" };
+    for(int m = 0; m < 3; m++) {
+        bench_report(names[m], ops, "op", best[m]);
+        printf("%-28s %12.2f ns/op\n", "", best[m] / ops * 1e9);
+    }
+
+    free(stack);
+    vm_free(&p);
+    lex_delete(l);
+    free(in);
+    return 0;
+}
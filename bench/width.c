@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2025 therealblue24.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Width benchmark: a division-heavy kernel through the JIT, once on
+ * `long`s and once on `uint`s, which the width analysis lets divide in
+ * 32 bits, against the same in C with the divisor hidden from the
+ * compiler so it divides too.
+ */
+#include "bench.h"
+#include "jit.h"
+#include "opt.h"
+
+#define ITERS (1 << 23)
+#define ROUNDS 3
+
+/* Sum of the digits of everything from 1 to `n`, in C. */
+static int64_t c_digits32(int64_t n, uint32_t base)
+{
+    int64_t sum = 0;
+    for(; n > 0; n--) {
+        for(uint32_t x = (uint32_t)n; x != 0; x /= base) {
+            sum += x - x / base * base;
+        }
+    }
+    return sum;
+}
+
+static int64_t c_digits64(int64_t n, uint32_t base)
+{
+    int64_t sum = 0;
+    for(; n > 0; n--) {
+        for(int64_t x = n; x != 0; x /= base) {
+            sum += x - x / base * base;
+        }
+    }
+    return sum;
+}
+
+/* The same in stac, with the type of the digit sum's parameter and
+ * result in the first `%s`s, up to `%d`. */
+#define DIGITS                                                            \
+    "func digits %s -> %s do 0 while over 0 != do over dup 10 swap / 10 " \
+    "* swap - + swap 10 swap / swap end swap drop end\n"                  \
+    "0 %d while dup 0 < do swap over digits + swap -1 + end drop ret\n"
+
+static const struct {
+    const char *name;
+    const char *ty;
+    int64_t (*c)(int64_t n, uint32_t base);
+} kernels[] = {
+    { "digit sums, long", "long", c_digits64 },
+    { "digit sums, uint", "uint", c_digits32 },
+};
+
+int main(void)
+{
+    /* keep the compiler from knowing how many there are, or what it
+     * divides by */
+    volatile int64_t iters = ITERS;
+    volatile uint32_t base = 10;
+    for(size_t k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++) {
+        char src[512];
+        int len = snprintf(src, sizeof(src), DIGITS, kernels[k].ty,
+                           kernels[k].ty, (int)iters);
+        lex_t *l = lex_create();
+        lex_supply_src(l, (const uint8_t *)src, (size_t)len);
+        lex_supply_name(l, "<bench>");
+        lex_do(l);
+        ir_t ir;
+        jit_t j;
+        optstats_t st;
+        if(ir_build(&ir, l)) {
+            return 1;
+        }
+        opt_run(&ir, 1, &st);
+        if(jit_compile(&j, &ir, l)) {
+            return 1;
+        }
+
+        double best[2] = { 0 };
+        int64_t got = 0, want = 0;
+        for(int r = 0; r < ROUNDS; r++) {
+            double t = bench_now();
+            got = jit_run(&j);
+            t = bench_now() - t;
+            best[0] = r == 0 || t < best[0] ? t : best[0];
+
+            t = bench_now();
+            want = kernels[k].c(iters, base);
+            t = bench_now() - t;
+            best[1] = r == 0 || t < best[1] ? t : best[1];
+        }
+        if(got != want) {
+            printf("%s: mismatch: %" PRId64 " vs. %" PRId64 "\n",
+                   kernels[k].name, got, want);
+            return 1;
+        }
+
+        printf("%s:\n", kernels[k].name);
+        bench_report("  stac (JIT)", (double)iters, "number", best[0]);
+        bench_report("  C", (double)iters, "number", best[1]);
+        printf("  %.2fx C's time\n", best[0] / best[1]);
+
+        jit_free(&j);
+        ir_free(&ir);
+        lex_delete(l);
+    }
+    return 0;
+}
@@ -0,0 +1,261 @@
+	.text
+	.globl main
+	.type main, @function
+main:
+	pushq %rbp
+	movq %rsp, %rbp
+	pushq %rbx
+	pushq %r12
+	pushq %r13
+	pushq %r14
+	pushq %r15
+	subq $24, %rsp
+.Ltop0:
+	movq $10000000, %rbx
+	movq %rbx, %rdi
+	call stac_down
+	movq %rax, %rbx
+	leaq .Lfmt(%rip), %rdi
+	movq %rbx, %rsi
+	xorl %eax, %eax
+	call printf@PLT
+	movq $0, %rbx
+	movq $10000000, %r12
+	movq %rbx, %rdi
+	movq %r12, %rsi
+	call stac_sum
+	movq %rax, %rbx
+	leaq .Lfmt(%rip), %rdi
+	movq %rbx, %rsi
+	xorl %eax, %eax
+	call printf@PLT
+	movq $1000000, %rbx
+	movq %rbx, %rdi
+	call stac_even
+	movq %rax, %rbx
+	leaq .Lfmt(%rip), %rdi
+	movq %rbx, %rsi
+	xorl %eax, %eax
+	call printf@PLT
+	movq $1000001, %rbx
+	movq %rbx, %rdi
+	call stac_even
+	movq %rax, %rbx
+	leaq .Lfmt(%rip), %rdi
+	movq %rbx, %rsi
+	xorl %eax, %eax
+	call printf@PLT
+	movq $1000001, %rbx
+	movq %rbx, %rdi
+	call stac_odd
+	movq %rax, %rbx
+	leaq .Lfmt(%rip), %rdi
+	movq %rbx, %rsi
+	xorl %eax, %eax
+	call printf@PLT
+	movq $5, %rbx
+	movq %rbx, %rdi
+	call stac_twice
+	movq %rax, %rbx
+	leaq .Lfmt(%rip), %rdi
+	movq %rbx, %rsi
+	xorl %eax, %eax
+	call printf@PLT
+	movq $0, %rbx
+	movq %rbx, %rax
+	jmp .Lret0
+	xorl %eax, %eax
+.Lret0:
+	leaq -40(%rbp), %rsp
+	popq %r15
+	popq %r14
+	popq %r13
+	popq %r12
+	popq %rbx
+	popq %rbp
+	ret
+	.size main, .-main
+	.type stac_down, @function
+stac_down:
+	pushq %rbp
+	movq %rsp, %rbp
+	pushq %rbx
+	pushq %r12
+	pushq %r13
+	pushq %r14
+	pushq %r15
+	subq $40, %rsp
+.Ltop1:
+	movq %rdi, %rbx
+	cmpq $0, %rbx
+	jle .L3
+.L2:
+	addq $-1, %rbx
+	movq %rbx, %rdi
+	jmp .Ltop1
+.L3:
+	movq %rbx, %rax
+	jmp .Lret1
+	xorl %eax, %eax
+.Lret1:
+	leaq -40(%rbp), %rsp
+	popq %r15
+	popq %r14
+	popq %r13
+	popq %r12
+	popq %rbx
+	popq %rbp
+	ret
+	.size stac_down, .-stac_down
+	.type stac_sum, @function
+stac_sum:
+	pushq %rbp
+	movq %rsp, %rbp
+	pushq %rbx
+	pushq %r12
+	pushq %r13
+	pushq %r14
+	pushq %r15
+	subq $40, %rsp
+.Ltop2:
+	movq %rdi, %rbx
+	movq %rsi, %r12
+	cmpq $0, %r12
+	jle .L6
+.L5:
+	movq %r12, %r13
+	addq %rbx, %r13
+	addq $-1, %r12
+	movq %r13, %rdi
+	movq %r12, %rsi
+	jmp .Ltop2
+.L6:
+.L7:
+	movq %rbx, %rax
+	jmp .Lret2
+	xorl %eax, %eax
+.Lret2:
+	leaq -40(%rbp), %rsp
+	popq %r15
+	popq %r14
+	popq %r13
+	popq %r12
+	popq %rbx
+	popq %rbp
+	ret
+	.size stac_sum, .-stac_sum
+	.type stac_even, @function
+stac_even:
+	pushq %rbp
+	movq %rsp, %rbp
+	pushq %rbx
+	pushq %r12
+	pushq %r13
+	pushq %r14
+	pushq %r15
+	subq $40, %rsp
+.Ltop3:
+	movq %rdi, %rbx
+	cmpq $0, %rbx
+	jle .L10
+.L9:
+	addq $-1, %rbx
+	movq %rbx, %rdi
+	leaq -40(%rbp), %rsp
+	popq %r15
+	popq %r14
+	popq %r13
+	popq %r12
+	popq %rbx
+	popq %rbp
+	jmp stac_odd
+.L10:
+	movq $1, %rbx
+.L11:
+	movq %rbx, %rax
+	jmp .Lret3
+	xorl %eax, %eax
+.Lret3:
+	leaq -40(%rbp), %rsp
+	popq %r15
+	popq %r14
+	popq %r13
+	popq %r12
+	popq %rbx
+	popq %rbp
+	ret
+	.size stac_even, .-stac_even
+	.type stac_odd, @function
+stac_odd:
+	pushq %rbp
+	movq %rsp, %rbp
+	pushq %rbx
+	pushq %r12
+	pushq %r13
+	pushq %r14
+	pushq %r15
+	subq $40, %rsp
+.Ltop4:
+	movq %rdi, %rbx
+	cmpq $0, %rbx
+	jle .L14
+.L13:
+	addq $-1, %rbx
+	movq %rbx, %rdi
+	leaq -40(%rbp), %rsp
+	popq %r15
+	popq %r14
+	popq %r13
+	popq %r12
+	popq %rbx
+	popq %rbp
+	jmp stac_even
+.L14:
+	movq $0, %rbx
+.L15:
+	movq %rbx, %rax
+	jmp .Lret4
+	xorl %eax, %eax
+.Lret4:
+	leaq -40(%rbp), %rsp
+	popq %r15
+	popq %r14
+	popq %r13
+	popq %r12
+	popq %rbx
+	popq %rbp
+	ret
+	.size stac_odd, .-stac_odd
+	.type stac_twice, @function
+stac_twice:
+	pushq %rbp
+	movq %rsp, %rbp
+	pushq %rbx
+	pushq %r12
+	pushq %r13
+	pushq %r14
+	pushq %r15
+	subq $24, %rsp
+.Ltop5:
+	movq %rdi, %rbx
+	movq %rbx, %rdi
+	call stac_down
+	movq %rax, %rbx
+	addq $1, %rbx
+	movq %rbx, %rax
+	jmp .Lret5
+	xorl %eax, %eax
+.Lret5:
+	leaq -40(%rbp), %rsp
+	popq %r15
+	popq %r14
+	popq %r13
+	popq %r12
+	popq %rbx
+	popq %rbp
+	ret
+	.size stac_twice, .-stac_twice
+	.section .rodata
+.Lfmt:
+	.asciz "%llu\n"
+	.section .note.GNU-stack,"",@progbits
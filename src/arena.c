@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2025 therealblue24.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Bump allocator.
+ */
+#include "arena.h"
+
+struct arena_chunk {
+    struct arena_chunk *next; /* older chunk */
+    size_t used, cap; /* of `data` */
+    _Alignas(max_align_t) uint8_t data[];
+};
+
+/* Set up an empty arena. */
+void arena_init(arena_t *a)
+{
+    a->head = NULL;
+    a->nallocs = a->nchunks = a->bytes = 0;
+}
+
+/* Allocate `size` bytes aligned to `align` (a power of two).
+ * Never fails; running out of memory exits like `zalloc`. */
+void *arena_alloc_aligned(arena_t *a, size_t size, size_t align)
+{
+    struct arena_chunk *c = a->head;
+    size_t at = c ? (c->used + align - 1) & ~(align - 1) : 0;
+
+    if(!c || at + size > c->cap) {
+        /* big allocations get a chunk of their own */
+        size_t cap = size_max(ARENA_CHUNK, size + align);
+        c = malloc(sizeof(*c) + cap);
+        ASSERT(c, "failed to allocate %zu byte arena chunk!", cap);
+        c->used = 0;
+        c->cap = cap;
+        /* keep bump-allocating from the old head if this was a big one */
+        if(a->head && size + align > ARENA_CHUNK) {
+            c->next = a->head->next;
+            a->head->next = c;
+        } else {
+            c->next = a->head;
+            a->head = c;
+        }
+        a->nchunks++;
+        at = 0;
+    }
+
+    c->used = at + size;
+    a->nallocs++;
+    a->bytes += size;
+    return c->data + at;
+}
+
+/* Free everything allocated from `a` in one go. */
+void arena_free(arena_t *a)
+{
+    struct arena_chunk *c = a->head;
+    while(c) {
+        struct arena_chunk *next = c->next;
+        free(c);
+        c = next;
+    }
+    arena_init(a);
+}
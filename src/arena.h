@@ -0,0 +1,44 @@
+/*
+ * Copyright (C) 2025 therealblue24.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Header file for the bump allocator.
+ */
+#ifndef ARENA_H_
+#define ARENA_H_
+
+#include "util.h"
+
+/* default chunk size */
+#define ARENA_CHUNK (64 * 1024)
+
+struct arena_chunk;
+
+/* Bump allocator. Everything in it is freed at once by `arena_free`. */
+typedef struct arena {
+    struct arena_chunk *head; /* chunk we are allocating from */
+
+    /* -- stats -- */
+    size_t nallocs; /* `arena_alloc` calls */
+    size_t nchunks; /* actual malloc()s */
+    size_t bytes; /* bytes handed out */
+} arena_t;
+
+/* Set up an empty arena. */
+void arena_init(arena_t *a);
+
+/* Allocate `size` bytes aligned to `align` (a power of two).
+ * Never fails; running out of memory exits like `zalloc`. */
+void *arena_alloc_aligned(arena_t *a, size_t size, size_t align);
+
+/* Allocate `size` bytes with the alignment of any object. */
+#define arena_alloc(a, size) \
+    arena_alloc_aligned((a), (size), _Alignof(max_align_t))
+
+/* Free everything allocated from `a` in one go. */
+void arena_free(arena_t *a);
+
+#endif /* ARENA_H_ */
@@ -1,112 +1,444 @@
 #include "cg.h"
 #include "lex.h"
+#include "width.h"
 
-static void prelude(FILE *to)
+/* Emit the symbol function `f` of `ir` goes by in the output. */
+void cg_fsym(emit_t *to, const ir_t *ir, const irfunc_t *f)
 {
-    fprintf(to, "data $fmt = { b \"%%llu\\n\", b 0 }\n");
-    fprintf(to, "export function w $main() {\n");
-    fprintf(to, "@start\n");
+    static const char hex[] = "0123456789abcdef";
+    const uint8_t *name = ir_fname(ir, f);
+    emit_lit(to, "stac_");
+    for(uint32_t k = 0; k < f->len; k++) {
+        uint8_t c = name[k];
+        if(c == '_') {
+            emit_lit(to, "__");
+        } else if((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+                  (c >= '0' && c <= '9')) {
+            emit_char(to, (char)c);
+        } else {
+            emit_char(to, '_');
+            emit_char(to, hex[c >> 4]);
+            emit_char(to, hex[c & 15]);
+        }
+    }
 }
 
-static void end(FILE *to)
+static void prelude(emit_t *to, bool prints)
 {
-    fprintf(to, "\n\tret 0\n}\n");
+    if(prints) {
+        emit_lit(to, "data $fmt = { b \"%llu\\n\", b 0 }\n");
+    }
+    emit_lit(to, "export function w $main() {\n");
+    emit_lit(to, "@start\n");
 }
 
-static int uflowcheck(int stack_index, lex_t *lex, token_t it, int min)
+/* End `main`, whose last op was `last` (-1 for none): running off the
+ * end returns 0. */
+static void end(emit_t *to, int last)
 {
-    if(stack_index < min) {
-        COMP_ERR(lex->name, it.line, it.col, it.raw - it.col,
-                 lex->lines.elems[it.line], it.range, "stack underflow");
-        return 1;
+    if(!ir_ends_block(last)) {
+        emit_lit(to, "\n\tret 0\n");
     }
-    return 0;
+    emit_lit(to, "}\n");
+}
+
+/* QBE type of each IRT_* in a signature */
+static const char *const abitys[] = {
+    [IRT_L] = "l",   [IRT_UL] = "l",  [IRT_W] = "w",
+    [IRT_UW] = "w",  [IRT_H] = "sh",  [IRT_UH] = "uh",
+    [IRT_B] = "sb",  [IRT_UB] = "ub",
+};
+
+/* QBE instruction extending each IRT_* to `l`, from the low bits of a
+ * `w` for the narrow ones */
+static const char *const exts[] = {
+    [IRT_L] = "copy",   [IRT_UL] = "copy",  [IRT_W] = "extsw",
+    [IRT_UW] = "extuw", [IRT_H] = "extsh",  [IRT_UH] = "extuh",
+    [IRT_B] = "extsb",  [IRT_UB] = "extub",
+};
+
+/* Emit the start of function `f`, whose first block is `blk`. The
+ * parameters come in as `%pN`, see IR_PARAM; tail calls of `f` set
+ * them again and jump back to `blk`, so an empty block comes first. */
+static void func_start(const ir_t *ir, const irfunc_t *f, uint32_t blk,
+                       emit_t *to)
+{
+    emit_lit(to, "function ");
+    if(f->ret != IRT_NONE) {
+        emit_str(to, abitys[f->ret]);
+        emit_char(to, ' ');
+    }
+    emit_char(to, '$');
+    cg_fsym(to, ir, f);
+    emit_char(to, '(');
+    for(uint32_t k = 0; k < f->nparams; k++) {
+        if(k > 0) {
+            emit_lit(to, ", ");
+        }
+        emit_str(to, abitys[f->params[k]]);
+        emit_lit(to, " %p");
+        emit_u64(to, k);
+    }
+    emit_lit(to, ") {\n@top\n@b");
+    emit_u64(to, blk);
+    emit_char(to, '\n');
+}
+
+/* Emit the end of a function that isn't `main`, which unlike `main`
+ * never runs into it. */
+static void func_end(emit_t *to)
+{
+    emit_lit(to, "}\n");
+}
+
+/* QBE instruction of each binop */
+static const char *const binops[IR_COUNT] = {
+    [IR_ADD] = "add",  [IR_SUB] = "sub",   [IR_MUL] = "mul",
+    [IR_DIV] = "div",  [IR_EQ] = "ceql",   [IR_NE] = "cnel",
+    [IR_LT] = "csltl", [IR_LE] = "cslel",  [IR_GT] = "csgtl",
+    [IR_GE] = "csgel",
+};
+
+/* The same for the unsigned divisions and comparisons, see `uns`. */
+static const char *const binops_ul[IR_COUNT] = {
+    [IR_DIV] = "udiv", [IR_EQ] = "ceql",  [IR_NE] = "cnel",
+    [IR_LT] = "cultl", [IR_LE] = "culel", [IR_GT] = "cugtl",
+    [IR_GE] = "cugel",
+};
+
+/* The same on `w`s, for divisions and comparisons `width_op` finds
+ * narrow enough, signed and unsigned. Sums, differences and products
+ * can outgrow 32 bits, so they're only `w`s where nothing reads more
+ * than their low bits, see `width_wide`; they use `binops`. */
+static const char *const binops_w[IR_COUNT] = {
+    [IR_DIV] = "div",  [IR_EQ] = "ceqw",  [IR_NE] = "cnew",
+    [IR_LT] = "csltw", [IR_LE] = "cslew", [IR_GT] = "csgtw",
+    [IR_GE] = "csgew",
+};
+
+static const char *const binops_uw[IR_COUNT] = {
+    [IR_DIV] = "udiv", [IR_EQ] = "ceqw",  [IR_NE] = "cnew",
+    [IR_LT] = "cultw", [IR_LE] = "culew", [IR_GT] = "cugtw",
+    [IR_GE] = "cugew",
+};
+
+/* Emit the label of block `id`. */
+static void emit_blk(emit_t *to, uint32_t id)
+{
+    if(id == 0) {
+        emit_lit(to, "@start");
+    } else {
+        emit_lit(to, "@b");
+        emit_u64(to, id);
+    }
+}
+
+/* Emit `OP %sA, %sB`, or `OP IMM, %sB`, and the newline. */
+static void emit_operands(emit_t *to, const char *op, const irins_t *in)
+{
+    emit_str(to, op);
+    emit_char(to, ' ');
+    if(in->a == IR_NOREG) {
+        emit_i64(to, in->imm.i);
+    } else {
+        emit_reg(to, (int)in->a);
+    }
+    emit_lit(to, ", ");
+    emit_reg(to, (int)in->b);
+    emit_char(to, '\n');
+}
+
+/* Emit `%sD =l OP %sA, %sB`, or `OP IMM, %sB`; into `%rD =w` if `w`. */
+static void emit_binop(emit_t *to, const char *op, const irins_t *in, bool w)
+{
+    if(w) {
+        emit_lit(to, "%r");
+        emit_u64(to, in->dst);
+        emit_lit(to, " =w ");
+    } else {
+        emit_reg(to, (int)in->dst);
+        emit_lit(to, " =l ");
+    }
+    emit_operands(to, op, in);
 }
 
-#define returnif(x)   \
-    do {              \
-        if((x)) {     \
-            return 1; \
-        }             \
-    } while(0);
+/* Emit sum, difference or product `in`, a `w` if `wide` says nothing
+ * reads more than its low 32 bits. */
+static void emit_arith(emit_t *to, const bool *wide, const irins_t *in)
+{
+    emit_reg(to, (int)in->dst);
+    emit_str(to, wide[in->dst] ? " =l " : " =w ");
+    emit_operands(to, binops[in->op], in);
+}
 
-#define ufcheck(si, l, x, n) returnif(uflowcheck(si, l, x, n));
+/* Emit division or comparison `in`, unsigned or in 32 bits if
+ * `width_op` says so with the registers' `widths`. */
+static void emit_narrow(emit_t *to, const uint8_t *widths, const irins_t *in)
+{
+    int ty = width_op(widths, in);
+    if(ir_wide(ty)) {
+        emit_binop(to, (ty == IRT_UL ? binops_ul : binops)[in->op], in,
+                   false);
+        return;
+    }
+    const char *op = (ty == IRT_UW ? binops_uw : binops_w)[in->op];
+    if(!ir_is_cmp(in->op)) {
+        /* the quotient comes back extended, like a narrow result */
+        emit_binop(to, op, in, true);
+        emit_reg(to, (int)in->dst);
+        emit_lit(to, " =l ");
+        emit_str(to, exts[ty]);
+        emit_lit(to, " %r");
+        emit_u64(to, in->dst);
+        emit_char(to, '\n');
+        return;
+    }
+    emit_binop(to, op, in, false);
+}
 
-/* emit code to file `to` */
-int cg_emit(lex_t *lex, FILE *to)
+/* Emit `%sD =l copy `, the start of a copy into `in->dst`. */
+static void emit_copy(emit_t *to, const irins_t *in)
 {
-    prelude(to);
-    (void)to;
-    int stack_index = 0;
-    list_foreach(&lex->toks) {
-        switch(it.toktype) {
-        case TOK_ADD:
-            ufcheck(stack_index, lex, it, 1);
-            fprintf(to, "%%s%d =l add %%s%d, %%s%d\n", stack_index - 2,
-                    stack_index - 1, stack_index - 2);
-            stack_index--;
-            break;
-        case TOK_SUB:
-            ufcheck(stack_index, lex, it, 1);
-            fprintf(to, "%%s%d =l sub %%s%d, %%s%d\n", stack_index - 2,
-                    stack_index - 1, stack_index - 2);
-            stack_index--;
-            break;
-        case TOK_MUL:
-            ufcheck(stack_index, lex, it, 1);
-            fprintf(to, "%%s%d =l mul %%s%d, %%s%d\n", stack_index - 2,
-                    stack_index - 1, stack_index - 2);
-            stack_index--;
-            break;
-        case TOK_DIV:
-            ufcheck(stack_index, lex, it, 1);
-            fprintf(to, "%%s%d =l div %%s%d, %%s%d\n", stack_index - 2,
-                    stack_index - 1, stack_index - 2);
-            stack_index--;
-            break;
-        case TOK_DUMP:
-            ufcheck(stack_index, lex, it, 1);
-            fprintf(to, "call $printf(l $fmt, ..., l %%s%d)\n",
-                    stack_index - 1);
-            stack_index--;
-            break;
-        case TOK_DUP:
-            fprintf(to, "%%s%d =l copy %%s%d\n", stack_index, stack_index - 1);
-            stack_index++;
-            break;
-        case TOK_DROP:
-            ufcheck(stack_index, lex, it, 1);
-            stack_index--;
-            break;
-        case TOK_DROPALL:
-            stack_index = 0;
-            break;
-        case TOK_RET:
-            fprintf(to, "ret %%s%d\n@thing_stack_%d", stack_index - 1,
-                    stack_index);
-            stack_index = 0;
-            break;
-        case TOK_NUM_INTU:
-            fprintf(to, "%%s%d =l copy %llu\n", stack_index,
-                    it.tok_num.unsignd);
-            stack_index++;
-            break;
-        case TOK_NUM_INT:
-            fprintf(to, "%%s%d =l copy %lld\n", stack_index, it.tok_num.signd);
-            stack_index++;
-            break;
-        case TOK_SPECIAL_LIT:
-            fprintf(to, "%%s%d =l call $%.*s()\n", stack_index, (int)it.range,
-                    it.tokl_lit);
-            stack_index++;
+    emit_reg(to, (int)in->dst);
+    emit_lit(to, " =l copy ");
+}
+
+/* Emit a call of the function op `in` calls, with the arguments in
+ * `args`. */
+static void emit_callf(const ir_t *ir, const irins_t *in, const uint32_t *args,
+                       emit_t *to)
+{
+    const irfunc_t *f = &ir->funcs[in->imm.func.fn];
+    if(in->dst != IR_NOREG) {
+        /* narrow results come back in a `w`, and get extended here */
+        if(ir_wide(f->ret)) {
+            emit_reg(to, (int)in->dst);
+            emit_lit(to, " =l ");
+        } else {
+            emit_lit(to, "%r");
+            emit_u64(to, in->dst);
+            emit_lit(to, " =w ");
+        }
+    }
+    emit_lit(to, "call $");
+    cg_fsym(to, ir, f);
+    emit_char(to, '(');
+    for(uint32_t k = 0; k < f->nparams; k++) {
+        if(k > 0) {
+            emit_lit(to, ", ");
+        }
+        emit_str(to, abitys[f->params[k]]);
+        emit_char(to, ' ');
+        emit_reg(to, (int)args[k]);
+    }
+    emit_lit(to, ")\n");
+    if(in->dst != IR_NOREG && !ir_wide(f->ret)) {
+        emit_reg(to, (int)in->dst);
+        emit_lit(to, " =l ");
+        emit_str(to, exts[f->ret]);
+        emit_lit(to, " %r");
+        emit_u64(to, in->dst);
+        emit_char(to, '\n');
+    }
+}
+
+/* Emit a tail call in function `cur`, of the function op `in` (the
+ * `i`-th) calls, with the arguments in `args`. QBE has no tail jumps,
+ * so only calls of `cur` itself turn into a loop. */
+static void emit_tail(const ir_t *ir, const irfunc_t *cur, const irins_t *in,
+                      size_t i, const uint32_t *args, emit_t *to)
+{
+    const irfunc_t *f = &ir->funcs[in->imm.func.fn];
+    if(f == cur) {
+        for(uint32_t k = 0; k < f->nparams; k++) {
+            emit_lit(to, "%p");
+            emit_u64(to, k);
+            emit_str(to, ir_wide(f->params[k]) ? " =l" : " =w");
+            emit_lit(to, " copy ");
+            emit_reg(to, (int)args[k]);
+            emit_char(to, '\n');
+        }
+        emit_lit(to, "jmp ");
+        emit_blk(to, ir->ins[f->start].imm.func.blk);
+        emit_char(to, '\n');
+        return;
+    }
+    /* a result of the same type as the caller's goes back as it is */
+    if(cur->ret != IRT_NONE) {
+        emit_lit(to, "%t");
+        emit_u64(to, i);
+        emit_str(to, ir_wide(cur->ret) ? " =l " : " =w ");
+    }
+    emit_lit(to, "call $");
+    cg_fsym(to, ir, f);
+    emit_char(to, '(');
+    for(uint32_t k = 0; k < f->nparams; k++) {
+        if(k > 0) {
+            emit_lit(to, ", ");
+        }
+        emit_str(to, abitys[f->params[k]]);
+        emit_char(to, ' ');
+        emit_reg(to, (int)args[k]);
+    }
+    emit_lit(to, ")\nret");
+    if(cur->ret != IRT_NONE) {
+        emit_lit(to, " %t");
+        emit_u64(to, i);
+    }
+    emit_char(to, '\n');
+}
+
+/* print QBE for `ir` to `to` */
+void cg_qbe(const ir_t *ir, emit_t *to)
+{
+    /* arguments of the call coming up */
+    LIST(uint32_t) args = { 0 };
+    const irfunc_t *f = ir->funcs; /* the one at hand */
+    uint8_t *widths = width_infer(ir);
+    bool *wide = width_wide(ir);
+    prelude(to, ir_prints(ir));
+    for(size_t i = 0; i < ir->size; i++) {
+        const irins_t *in = &ir->ins[i];
+        switch(in->op) {
+        case IR_ADD:
+        case IR_SUB:
+        case IR_MUL:
+            emit_arith(to, wide, in);
+            break;
+        case IR_DIV:
+        case IR_EQ:
+        case IR_NE:
+        case IR_LT:
+        case IR_LE:
+        case IR_GT:
+        case IR_GE:
+            emit_narrow(to, widths, in);
+            break;
+        case IR_DUMP:
+            emit_lit(to, "call $printf(l $fmt, ..., l ");
+            emit_reg(to, (int)in->a);
+            emit_lit(to, ")\n");
+            break;
+        case IR_RET:
+        case IR_TAIL:
+            /* nothing follows but a label or the end, see `ir_prune` */
+            if(in->op == IR_TAIL) {
+                args.size -= ir->funcs[in->imm.func.fn].nparams;
+                emit_tail(ir, f, in, i, args.elems + args.size, to);
+            } else {
+                emit_lit(to, "ret");
+                if(in->a != IR_NOREG) {
+                    emit_char(to, ' ');
+                    emit_reg(to, (int)in->a);
+                }
+                emit_char(to, '\n');
+            }
+            break;
+        case IR_UCONST:
+            emit_copy(to, in);
+            emit_u64(to, in->imm.u);
+            emit_char(to, '\n');
+            break;
+        case IR_ICONST:
+            emit_copy(to, in);
+            emit_i64(to, in->imm.i);
+            emit_char(to, '\n');
+            break;
+        case IR_CALL:
+            emit_reg(to, (int)in->dst);
+            emit_lit(to, " =l call $");
+            emit_bytes(to, ir_sym(ir, in), in->imm.sym.len);
+            emit_lit(to, "()\n");
+            break;
+        case IR_FUNC:
+            /* the one before is done */
+            if(f == ir->funcs) {
+                end(to, i > 0 ? ir->ins[i - 1].op : -1);
+            } else {
+                func_end(to);
+            }
+            f = &ir->funcs[in->imm.func.fn];
+            func_start(ir, f, in->imm.func.blk, to);
+            break;
+        case IR_PARAM:
+            emit_reg(to, (int)in->dst);
+            emit_lit(to, " =l ");
+            emit_str(to, exts[f->params[in->imm.i]]);
+            emit_lit(to, " %p");
+            emit_i64(to, in->imm.i);
+            emit_char(to, '\n');
+            break;
+        case IR_EXT:
+            emit_reg(to, (int)in->dst);
+            emit_lit(to, " =l ");
+            emit_str(to, exts[in->imm.i]);
+            emit_char(to, ' ');
+            emit_reg(to, (int)in->a);
+            emit_char(to, '\n');
+            break;
+        case IR_ARG:
+            list_append(&args, in->a);
+            break;
+        case IR_CALLF:
+            args.size -= ir->funcs[in->imm.func.fn].nparams;
+            emit_callf(ir, in, args.elems + args.size, to);
+            break;
+        case IR_LABEL:
+            emit_blk(to, in->imm.blk[0]);
+            emit_char(to, '\n');
+            break;
+        case IR_JMP:
+            emit_lit(to, "jmp ");
+            emit_blk(to, in->imm.blk[0]);
+            emit_char(to, '\n');
+            break;
+        case IR_JNZ:
+            emit_lit(to, "jnz ");
+            emit_reg(to, (int)in->a);
+            emit_lit(to, ", ");
+            emit_blk(to, in->imm.blk[0]);
+            emit_lit(to, ", ");
+            emit_blk(to, in->imm.blk[1]);
+            emit_char(to, '\n');
+            break;
+        case IR_PHI:
+            emit_reg(to, (int)in->dst);
+            emit_lit(to, " =l phi ");
+            emit_blk(to, in->imm.blk[0]);
+            emit_char(to, ' ');
+            emit_reg(to, (int)in->a);
+            if(in->b != IR_NOREG) {
+                emit_lit(to, ", ");
+                emit_blk(to, in->imm.blk[1]);
+                emit_char(to, ' ');
+                emit_reg(to, (int)in->b);
+            }
+            emit_char(to, '\n');
             break;
         default:
-            COMP_ERR(lex->name, it.line, it.col, it.raw - it.col,
-                     lex->lines.elems[it.line], it.range, "unsupported op");
-            return 1;
+            /* IR_NOP and the stack shuffles: nothing to do */
             break;
         }
     }
-    end(to);
+    free(args.elems);
+    free(widths);
+    free(wide);
+    if(f == ir->funcs) {
+        end(to, ir->size > 0 ? ir->ins[ir->size - 1].op : -1);
+    } else {
+        func_end(to);
+    }
+}
+
+/* emit code to `to` */
+int cg_emit(lex_t *lex, emit_t *to)
+{
+    ir_t ir;
+    if(ir_build(&ir, lex)) {
+        ir_free(&ir);
+        return 1;
+    }
+    cg_qbe(&ir, to);
+    ir_free(&ir);
     return 0;
 }
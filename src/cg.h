@@ -12,8 +12,33 @@
 
 #include "util.h"
 #include "lex.h"
+#include "emit.h"
+#include "ir.h"
 
-/* emit code to file `to` */
-int cg_emit(lex_t *lex, FILE *to);
+/* Emit the symbol function `f` of `ir` goes by in the output: its name
+ * after `stac_`, with `_` doubled and any byte that's not a letter or a
+ * digit as `_` and two hex digits, so `my-fn` is `stac_my_2dfn`. That
+ * keeps it clear of libc, of the top-level `main` and of the names the
+ * code generators use themselves, and something an assembler takes. */
+void cg_fsym(emit_t *to, const ir_t *ir, const irfunc_t *f);
+
+/* print QBE for `ir` to `to` */
+void cg_qbe(const ir_t *ir, emit_t *to);
+
+/* print x86-64 assembly for `ir` to `to` */
+void cg_x64(const ir_t *ir, emit_t *to);
+
+/* Address of the function op `in` calls, NULL if there's none. */
+typedef const void *(*cg_resolve_fn)(void *ctx, const irins_t *in);
+
+/* Assemble `ir` into x86-64 machine code for an `int64_t (void)`
+ * function, put in `*code` (freed by the caller), `*size` bytes long.
+ * `resolve` gives the address of every function called.
+ * Returns nonzero if any of those can't be resolved. */
+int cg_x64_code(const ir_t *ir, cg_resolve_fn resolve, void *ctx,
+                uint8_t **code, size_t *size);
+
+/* emit code to `to`, building the IR on the way */
+int cg_emit(lex_t *lex, emit_t *to);
 
 #endif /* CG_H_ */
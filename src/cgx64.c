@@ -0,0 +1,1375 @@
+/*
+ * Copyright (C) 2025 therealblue24.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * x86-64 (System V) backend: GNU as syntax, or machine code for the JIT.
+ *
+ * Values live in the callee-saved registers, so calls (printf included)
+ * leave them alone. When those run out, the value deepest down the
+ * stack goes to a cell in the frame: in a stack machine that's the one
+ * needed last, so the top of the stack stays in registers. Registers
+ * and cells are handed back after the last use of their value.
+ *
+ * Values only cross blocks as phis, and the i-th phi of every block
+ * has a fixed home: the i-th register of the pool, then cells set
+ * aside for it. Every jump moves what it hands the phis of its target
+ * into their homes (all at once, as a parallel move), so loops keep
+ * the stack in registers from one iteration to the next.
+ *
+ * Functions take their parameters the System V way, the first six in
+ * registers and the rest on the stack, and return in %rax. Parameters
+ * and results narrower than 64 bits get extended on the way in, by the
+ * callee and the caller respectively. Divisions of values that fit in
+ * 32 bits (see width.h) use the 32-bit instructions, which take a lot
+ * less time than the 64-bit ones. A tail call of the function at
+ * hand puts the arguments where the parameters came in and jumps back
+ * past the prelude; one of another function takes the frame down and
+ * jumps to it, so recursion in tail position runs in constant stack.
+ *
+ * The same allocator drives both outputs, only the instruction forms
+ * at the top know whether they print or encode.
+ */
+#include "cg.h"
+#include "width.h"
+
+/* hardware register numbers */
+enum {
+    RAX = 0,
+    RCX = 1,
+    RDX = 2,
+    RBX = 3,
+    RSP = 4,
+    RBP = 5,
+    RSI = 6,
+    RDI = 7,
+    R8 = 8,
+    R9 = 9,
+    R12 = 12,
+    R13 = 13,
+    R14 = 14,
+    R15 = 15,
+};
+
+static const char *const regnames[16] = {
+    "%rax", "%rcx", "%rdx", "%rbx", "%rsp", "%rbp", "%rsi", "%rdi",
+    "%r8",  "%r9",  "%r10", "%r11", "%r12", "%r13", "%r14", "%r15",
+};
+
+/* the same, 32, 16 and 8 bits wide */
+static const char *const subregnames[3][16] = {
+    { "%eax", "%ecx", "%edx", "%ebx", "%esp", "%ebp", "%esi", "%edi",
+      "%r8d", "%r9d", "%r10d", "%r11d", "%r12d", "%r13d", "%r14d", "%r15d" },
+    { "%ax", "%cx", "%dx", "%bx", "%sp", "%bp", "%si", "%di", "%r8w", "%r9w",
+      "%r10w", "%r11w", "%r12w", "%r13w", "%r14w", "%r15w" },
+    { "%al", "%cl", "%dl", "%bl", "%spl", "%bpl", "%sil", "%dil", "%r8b",
+      "%r9b", "%r10b", "%r11b", "%r12b", "%r13b", "%r14b", "%r15b" },
+};
+
+/* where arguments go */
+static const int argregs[] = { RDI, RSI, RDX, RCX, R8, R9 };
+#define NARGREGS ((int)(sizeof(argregs) / sizeof(argregs[0])))
+
+/* where values live, in the order they're handed out */
+static const int pool[] = { RBX, R12, R13, R14, R15 };
+#define NPOOL ((int)(sizeof(pool) / sizeof(pool[0])))
+
+/* saved registers under %rbp, in bytes */
+#define SAVED (NPOOL * 8)
+
+/* what `dump` prints with */
+static const char x64_fmt[] = "%llu\n";
+
+/* Where a value is: register `reg`, or frame cell `cell` if that's -1. */
+struct loc {
+    int reg;
+    int cell;
+};
+
+/* Register `r` as a location. */
+static inline struct loc R(int r)
+{
+    return (struct loc){ .reg = r, .cell = -1 };
+}
+
+/* Two-operand instructions. */
+enum { X_MOV, X_ADD, X_SUB, X_IMUL, X_CMP };
+
+static const struct {
+    const char *name;
+    uint8_t op[2], len; /* opcode of `op r/m, reg` */
+    uint8_t ext; /* ModRM.reg of `op $imm32, r/m`, if there's one */
+} alu[] = {
+    [X_MOV] = { "movq", { 0x8b }, 1, 0 },
+    [X_ADD] = { "addq", { 0x03 }, 1, 0 },
+    [X_SUB] = { "subq", { 0x2b }, 1, 5 },
+    [X_IMUL] = { "imulq", { 0x0f, 0xaf }, 2, 0 },
+    [X_CMP] = { "cmpq", { 0x3b }, 1, 7 },
+};
+
+/* Extending an IRT_* to 64 bits: `op r/m, reg` with the source
+ * `width` (an index into `subregnames`, plus one) wide. */
+static const struct {
+    const char *name;
+    uint8_t op[2], len;
+    bool w; /* REX.W, the destination is 64 bits */
+    uint8_t width;
+} exts[] = {
+    [IRT_L] = { "movq", { 0x8b }, 1, true, 0 },
+    [IRT_UL] = { "movq", { 0x8b }, 1, true, 0 },
+    [IRT_W] = { "movslq", { 0x63 }, 1, true, 1 },
+    [IRT_UW] = { "movl", { 0x8b }, 1, false, 1 },
+    [IRT_H] = { "movswq", { 0x0f, 0xbf }, 2, true, 2 },
+    [IRT_UH] = { "movzwq", { 0x0f, 0xb7 }, 2, true, 2 },
+    [IRT_B] = { "movsbq", { 0x0f, 0xbe }, 2, true, 3 },
+    [IRT_UB] = { "movzbq", { 0x0f, 0xb6 }, 2, true, 3 },
+};
+
+/* condition codes */
+enum {
+    CC_B = 2, CC_AE = 3, CC_E = 4, CC_NE = 5, CC_BE = 6, CC_A = 7,
+    CC_L = 12, CC_GE = 13, CC_LE = 14, CC_G = 15
+};
+
+static const char *const ccnames[16] = {
+    [CC_B] = "b",   [CC_AE] = "ae", [CC_E] = "e",  [CC_NE] = "ne",
+    [CC_BE] = "be", [CC_A] = "a",   [CC_L] = "l",  [CC_GE] = "ge",
+    [CC_LE] = "le", [CC_G] = "g",
+};
+
+/* A move from one place to another, at the end of a block. */
+struct move {
+    struct loc src, dst;
+};
+
+/* A jump to a block (or a call of a function), to fix up once the
+ * block is placed. */
+struct jfix {
+    uint32_t at; /* rel32 */
+    uint32_t blk; /* or function */
+};
+
+struct x64 {
+    const ir_t *ir;
+    emit_t *to; /* text goes here */
+    LIST(uint8_t) code; /* machine code goes here if `to` is NULL */
+    LIST(uint32_t) fixups; /* rel32s of jumps to the epilogue */
+    LIST(struct jfix) jumps; /* rel32s of jumps to blocks */
+    LIST(struct jfix) calls; /* rel32s of calls and tail jumps */
+    uint32_t *at; /* where every block starts */
+    uint32_t *fat; /* where every function starts */
+    uint32_t fn; /* function at hand */
+    uint32_t top; /* where its code starts, past the prelude */
+    int ntramp; /* text labels for the jumps in between */
+    cg_resolve_fn resolve;
+    void *ctx;
+    int err;
+
+    struct loc *loc; /* per vreg */
+    uint32_t *uses; /* reads left, per vreg */
+    uint8_t *width; /* IRT_* it fits, per vreg (see width.h) */
+    int32_t *slot; /* stack slot the value was pushed to, per vreg */
+    uint32_t owner[16]; /* vreg in each register, or IR_NOREG */
+    LIST(int) cells; /* free frame cells */
+    int ncells; /* cells handed out so far */
+    int nhome; /* cells set aside as homes of phis */
+    uint32_t blk; /* block at hand */
+    int nphi; /* phis of it so far */
+    uint32_t flags; /* comparison only in the flags, for a `jnz` */
+    int cc; /* ... and its condition */
+    LIST(uint32_t) args; /* of the call coming up */
+};
+
+/*
+ * Instruction forms.
+ */
+
+static void x64_u32(struct x64 *x, uint32_t v)
+{
+    list_append_many(&x->code, (uint8_t)v, (uint8_t)(v >> 8),
+                     (uint8_t)(v >> 16), (uint8_t)(v >> 24));
+}
+
+static void x64_u64(struct x64 *x, uint64_t v)
+{
+    x64_u32(x, (uint32_t)v);
+    x64_u32(x, (uint32_t)(v >> 32));
+}
+
+/* Offset of frame cell `cell` from %rbp. Negative cells are above
+ * the return address, in the caller's frame. */
+static int32_t x64_disp(int cell)
+{
+    return -SAVED - 8 * (cell + 1);
+}
+
+/* Where parameter `k` comes in. */
+static struct loc x64_param(int k)
+{
+    if(k < NARGREGS) {
+        return R(argregs[k]);
+    }
+    /* 16(%rbp) is the first on the stack */
+    return (struct loc){ .reg = -1, .cell = -(SAVED / 8 + 3 + k - NARGREGS) };
+}
+
+/* REX.W prefix for `reg` and `rm`. */
+static void x64_rex(struct x64 *x, int reg, struct loc rm)
+{
+    list_append(&x->code, (uint8_t)(0x48 | (reg >= 8) << 2 | (rm.reg >= 8)));
+}
+
+/* ModRM (and displacement) for `reg` and `rm`, cells are off %rbp. */
+static void x64_modrm(struct x64 *x, int reg, struct loc rm)
+{
+    if(rm.reg >= 0) {
+        list_append(&x->code, (uint8_t)(0xc0 | (reg & 7) << 3 | (rm.reg & 7)));
+        return;
+    }
+    int32_t d = x64_disp(rm.cell);
+    if(d >= INT8_MIN && d <= INT8_MAX) {
+        list_append_many(&x->code, (uint8_t)(0x45 | (reg & 7) << 3),
+                         (uint8_t)d);
+    } else {
+        list_append(&x->code, (uint8_t)(0x85 | (reg & 7) << 3));
+        x64_u32(x, (uint32_t)d);
+    }
+}
+
+static void x64_text_loc(struct x64 *x, struct loc l)
+{
+    if(l.reg >= 0) {
+        emit_str(x->to, regnames[l.reg]);
+    } else {
+        emit_i64(x->to, x64_disp(l.cell));
+        emit_lit(x->to, "(%rbp)");
+    }
+}
+
+/* `op src, dst`. One of them is a register, and only `mov` may store. */
+static void x64_op(struct x64 *x, int op, struct loc src, struct loc dst)
+{
+    if(x->to) {
+        emit_char(x->to, '\t');
+        emit_str(x->to, alu[op].name);
+        emit_char(x->to, ' ');
+        x64_text_loc(x, src);
+        emit_lit(x->to, ", ");
+        x64_text_loc(x, dst);
+        emit_char(x->to, '\n');
+        return;
+    }
+    if(dst.reg < 0) {
+        /* movq reg, r/m */
+        x64_rex(x, src.reg, dst);
+        list_append(&x->code, 0x89);
+        x64_modrm(x, src.reg, dst);
+        return;
+    }
+    x64_rex(x, dst.reg, src);
+    for(int i = 0; i < alu[op].len; i++) {
+        list_append(&x->code, alu[op].op[i]);
+    }
+    x64_modrm(x, dst.reg, src);
+}
+
+/* `reg = src`, extending IRT_* `ty` to 64 bits. */
+static void x64_ext(struct x64 *x, int ty, struct loc src, int reg)
+{
+    if(x->to) {
+        emit_char(x->to, '\t');
+        emit_str(x->to, exts[ty].name);
+        emit_char(x->to, ' ');
+        if(src.reg >= 0 && exts[ty].width > 0) {
+            emit_str(x->to, subregnames[exts[ty].width - 1][src.reg]);
+        } else {
+            x64_text_loc(x, src);
+        }
+        emit_lit(x->to, ", ");
+        emit_str(x->to, exts[ty].w ? regnames[reg] : subregnames[0][reg]);
+        emit_char(x->to, '\n');
+        return;
+    }
+    /* always a REX, so the low bytes of %rsi and %rdi are %sil and %dil */
+    list_append(&x->code, (uint8_t)(0x40 | exts[ty].w << 3 | (reg >= 8) << 2 |
+                                     (src.reg >= 8)));
+    for(int i = 0; i < exts[ty].len; i++) {
+        list_append(&x->code, exts[ty].op[i]);
+    }
+    x64_modrm(x, reg, src);
+}
+
+/* `movq $v, reg`. */
+static void x64_imm(struct x64 *x, int64_t v, int reg)
+{
+    /* only movabs takes a full 64-bit immediate */
+    bool small = v >= INT32_MIN && v <= INT32_MAX;
+    if(x->to) {
+        emit_str(x->to, small ? "\tmovq $" : "\tmovabsq $");
+        emit_i64(x->to, v);
+        emit_lit(x->to, ", ");
+        emit_str(x->to, regnames[reg]);
+        emit_char(x->to, '\n');
+        return;
+    }
+    x64_rex(x, 0, R(reg));
+    if(small) {
+        list_append(&x->code, 0xc7);
+        x64_modrm(x, 0, R(reg));
+        x64_u32(x, (uint32_t)v);
+    } else {
+        list_append(&x->code, (uint8_t)(0xb8 + (reg & 7)));
+        x64_u64(x, (uint64_t)v);
+    }
+}
+
+/* `op $v, dst`, for the ops with an `ext`. */
+static void x64_op_imm(struct x64 *x, int op, int32_t v, struct loc dst)
+{
+    if(x->to) {
+        emit_char(x->to, '\t');
+        emit_str(x->to, alu[op].name);
+        emit_lit(x->to, " $");
+        emit_i64(x->to, v);
+        emit_lit(x->to, ", ");
+        x64_text_loc(x, dst);
+        emit_char(x->to, '\n');
+        return;
+    }
+    x64_rex(x, 0, dst);
+    list_append(&x->code, 0x81);
+    x64_modrm(x, alu[op].ext, dst);
+    x64_u32(x, (uint32_t)v);
+}
+
+/* `imulq $v, reg, reg`. */
+static void x64_imul_imm(struct x64 *x, int32_t v, int reg)
+{
+    if(x->to) {
+        emit_lit(x->to, "\timulq $");
+        emit_i64(x->to, v);
+        emit_lit(x->to, ", ");
+        emit_str(x->to, regnames[reg]);
+        emit_lit(x->to, ", ");
+        emit_str(x->to, regnames[reg]);
+        emit_char(x->to, '\n');
+        return;
+    }
+    x64_rex(x, reg, R(reg));
+    list_append(&x->code, 0x69);
+    x64_modrm(x, reg, R(reg));
+    x64_u32(x, (uint32_t)v);
+}
+
+/* `negq reg`. */
+static void x64_neg(struct x64 *x, int reg)
+{
+    if(x->to) {
+        emit_lit(x->to, "\tnegq ");
+        emit_str(x->to, regnames[reg]);
+        emit_char(x->to, '\n');
+        return;
+    }
+    x64_rex(x, 0, R(reg));
+    list_append(&x->code, 0xf7);
+    x64_modrm(x, 3, R(reg));
+}
+
+/* `reg = cc ? 1 : 0`, off the flags. */
+static void x64_setcc(struct x64 *x, int cc, int reg)
+{
+    if(x->to) {
+        emit_lit(x->to, "\tset");
+        emit_str(x->to, ccnames[cc]);
+        emit_lit(x->to, " %al\n\tmovzbq %al, ");
+        emit_str(x->to, regnames[reg]);
+        emit_char(x->to, '\n');
+        return;
+    }
+    list_append_many(&x->code, 0x0f, (uint8_t)(0x90 + cc), 0xc0);
+    x64_rex(x, reg, R(RAX));
+    list_append_many(&x->code, 0x0f, 0xb6);
+    x64_modrm(x, reg, R(RAX));
+}
+
+/* Start of block `blk`. */
+static void x64_label(struct x64 *x, uint32_t blk)
+{
+    if(x->to) {
+        emit_lit(x->to, ".L");
+        emit_u64(x->to, blk);
+        emit_lit(x->to, ":\n");
+        return;
+    }
+    x->at[blk] = (uint32_t)x->code.size;
+}
+
+/* `jmp` (if `cc` is negative) or `j<cc>` to block `blk`. */
+static void x64_jmp(struct x64 *x, int cc, uint32_t blk)
+{
+    if(x->to) {
+        emit_lit(x->to, "\tj");
+        emit_str(x->to, cc < 0 ? "mp" : ccnames[cc]);
+        emit_lit(x->to, " .L");
+        emit_u64(x->to, blk);
+        emit_char(x->to, '\n');
+        return;
+    }
+    if(cc < 0) {
+        list_append(&x->code, 0xe9);
+    } else {
+        list_append_many(&x->code, 0x0f, (uint8_t)(0x80 + cc));
+    }
+    list_append(&x->jumps, ((struct jfix){ (uint32_t)x->code.size, blk }));
+    x64_u32(x, 0);
+}
+
+/* `j<cc>` a little further down, to where `x64_tramp` is called with
+ * what this returns. */
+static uint32_t x64_jcc_fwd(struct x64 *x, int cc)
+{
+    if(x->to) {
+        emit_lit(x->to, "\tj");
+        emit_str(x->to, ccnames[cc]);
+        emit_lit(x->to, " .Lt");
+        emit_i64(x->to, x->ntramp);
+        emit_char(x->to, '\n');
+        return (uint32_t)x->ntramp++;
+    }
+    list_append_many(&x->code, 0x0f, (uint8_t)(0x80 + cc));
+    x64_u32(x, 0);
+    return (uint32_t)x->code.size - 4;
+}
+
+static void x64_tramp(struct x64 *x, uint32_t fwd)
+{
+    if(x->to) {
+        emit_lit(x->to, ".Lt");
+        emit_u64(x->to, fwd);
+        emit_lit(x->to, ":\n");
+        return;
+    }
+    uint32_t rel = (uint32_t)x->code.size - (fwd + 4);
+    memcpy(x->code.elems + fwd, &rel, 4);
+}
+
+/* `%rax = %rax / src`, as `width_op` says: all 64 bits, signed for
+ * IRT_L and unsigned for IRT_UL, or the low halves of both, signed
+ * for IRT_W and unsigned for IRT_UW. */
+static void x64_idiv(struct x64 *x, int ty, struct loc src)
+{
+    bool u = ty == IRT_UL || ty == IRT_UW;
+    if(x->to) {
+        emit_str(x->to, ty == IRT_L    ? "\tcqto\n\tidivq "
+                        : ty == IRT_UL ? "\txorl %edx, %edx\n\tdivq "
+                        : ty == IRT_W  ? "\tcltd\n\tidivl "
+                                       : "\txorl %edx, %edx\n\tdivl ");
+        if(!ir_wide(ty) && src.reg >= 0) {
+            emit_str(x->to, subregnames[0][src.reg]);
+        } else {
+            x64_text_loc(x, src);
+        }
+        emit_char(x->to, '\n');
+        return;
+    }
+    if(ty == IRT_L) {
+        list_append_many(&x->code, 0x48, 0x99);
+    } else if(ty == IRT_W) {
+        list_append(&x->code, 0x99);
+    } else {
+        list_append_many(&x->code, 0x31, 0xd2);
+    }
+    if(ir_wide(ty)) {
+        x64_rex(x, 0, src);
+    } else if(src.reg >= 8) {
+        list_append(&x->code, 0x41);
+    }
+    list_append(&x->code, 0xf7);
+    x64_modrm(x, u ? 6 : 7, src);
+}
+
+/* `xorl %eax, %eax`: no vector registers for a varargs call, or
+ * returning 0. */
+static void x64_zero_eax(struct x64 *x)
+{
+    if(x->to) {
+        emit_lit(x->to, "\txorl %eax, %eax\n");
+    } else {
+        list_append_many(&x->code, 0x31, 0xc0);
+    }
+}
+
+/* Call `name` (`len` bytes), which is at `addr` for machine code. */
+static void x64_call(struct x64 *x, const uint8_t *name, size_t len,
+                     const void *addr)
+{
+    if(x->to) {
+        emit_lit(x->to, "\tcall ");
+        emit_bytes(x->to, name, len);
+        emit_lit(x->to, "@PLT\n");
+        return;
+    }
+    /* movabsq $addr, %r11; call *%r11 */
+    list_append_many(&x->code, 0x49, 0xbb);
+    x64_u64(x, (uint64_t)(uintptr_t)addr);
+    list_append_many(&x->code, 0x41, 0xff, 0xd3);
+}
+
+/* Call function `fn` of the program. */
+static void x64_callf_insn(struct x64 *x, uint32_t fn)
+{
+    if(x->to) {
+        const irfunc_t *f = &x->ir->funcs[fn];
+        emit_lit(x->to, "\tcall ");
+        cg_fsym(x->to, x->ir, f);
+        emit_char(x->to, '\n');
+        return;
+    }
+    list_append(&x->code, 0xe8);
+    list_append(&x->calls, ((struct jfix){ (uint32_t)x->code.size, fn }));
+    x64_u32(x, 0);
+}
+
+/* Point %rdi at the `dump` format. */
+static void x64_fmt_arg(struct x64 *x)
+{
+    if(x->to) {
+        emit_lit(x->to, "\tleaq .Lfmt(%rip), %rdi\n");
+        return;
+    }
+    list_append_many(&x->code, 0x48, 0xb8 + RDI);
+    x64_u64(x, (uint64_t)(uintptr_t)x64_fmt);
+}
+
+/* Jump to the epilogue. */
+static void x64_jmp_ret(struct x64 *x)
+{
+    if(x->to) {
+        emit_lit(x->to, "\tjmp .Lret");
+        emit_u64(x->to, x->fn);
+        emit_char(x->to, '\n');
+        return;
+    }
+    list_append(&x->code, 0xe9);
+    list_append(&x->fixups, (uint32_t)x->code.size);
+    x64_u32(x, 0);
+}
+
+static void x64_push(struct x64 *x, int reg, bool pop)
+{
+    if(x->to) {
+        emit_str(x->to, pop ? "\tpopq " : "\tpushq ");
+        emit_str(x->to, regnames[reg]);
+        emit_char(x->to, '\n');
+        return;
+    }
+    if(reg >= 8) {
+        list_append(&x->code, 0x41);
+    }
+    list_append(&x->code, (uint8_t)((pop ? 0x58 : 0x50) + (reg & 7)));
+}
+
+/* `pushq src`. */
+static void x64_push_loc(struct x64 *x, struct loc src)
+{
+    if(src.reg >= 0) {
+        x64_push(x, src.reg, false);
+    } else if(x->to) {
+        emit_lit(x->to, "\tpushq ");
+        x64_text_loc(x, src);
+        emit_char(x->to, '\n');
+    } else {
+        list_append(&x->code, 0xff);
+        x64_modrm(x, 6, src);
+    }
+}
+
+/* Name of the function at hand, for text. */
+static void x64_name(struct x64 *x)
+{
+    if(x->fn == 0) {
+        emit_lit(x->to, "main");
+    } else {
+        const irfunc_t *f = &x->ir->funcs[x->fn];
+        cg_fsym(x->to, x->ir, f);
+    }
+}
+
+static void x64_prelude(struct x64 *x, int32_t frame)
+{
+    if(x->to) {
+        /* only `main` is seen from outside */
+        if(x->fn == 0) {
+            emit_lit(x->to, "\t.globl main\n");
+        }
+        emit_lit(x->to, "\t.type ");
+        x64_name(x);
+        emit_lit(x->to, ", @function\n");
+        x64_name(x);
+        emit_lit(x->to, ":\n");
+    } else {
+        x->fat[x->fn] = (uint32_t)x->code.size;
+    }
+    x64_push(x, RBP, false);
+    x64_op(x, X_MOV, R(RSP), R(RBP));
+    for(int i = 0; i < NPOOL; i++) {
+        x64_push(x, pool[i], false);
+    }
+    if(x->to) {
+        emit_lit(x->to, "\tsubq $");
+        emit_i64(x->to, frame);
+        emit_lit(x->to, ", %rsp\n.Ltop");
+        emit_u64(x->to, x->fn);
+        emit_lit(x->to, ":\n");
+    } else {
+        list_append_many(&x->code, 0x48, 0x81, 0xec);
+        x64_u32(x, (uint32_t)frame);
+        x->top = (uint32_t)x->code.size;
+    }
+}
+
+/* Take the frame down again, up to the `ret`. */
+static void x64_leave(struct x64 *x)
+{
+    if(x->to) {
+        emit_lit(x->to, "\tleaq -");
+        emit_i64(x->to, SAVED);
+        emit_lit(x->to, "(%rbp), %rsp\n");
+    } else {
+        /* leaq -SAVED(%rbp), %rsp */
+        list_append_many(&x->code, 0x48, 0x8d, 0x65, (uint8_t)-SAVED);
+    }
+    for(int i = NPOOL; i-- > 0;) {
+        x64_push(x, pool[i], true);
+    }
+    x64_push(x, RBP, true);
+}
+
+/* Epilogue of the function at hand. */
+static void x64_epilogue(struct x64 *x)
+{
+    /* falling off the end returns 0 */
+    x64_zero_eax(x);
+    if(x->to) {
+        emit_lit(x->to, ".Lret");
+        emit_u64(x->to, x->fn);
+        emit_lit(x->to, ":\n");
+    } else {
+        for(size_t i = 0; i < x->fixups.size; i++) {
+            uint32_t at = x->fixups.elems[i];
+            uint32_t rel = (uint32_t)x->code.size - (at + 4);
+            memcpy(x->code.elems + at, &rel, 4);
+        }
+        x->fixups.size = 0;
+    }
+    x64_leave(x);
+    if(x->to) {
+        emit_lit(x->to, "\tret\n\t.size ");
+        x64_name(x);
+        emit_lit(x->to, ", .-");
+        x64_name(x);
+        emit_char(x->to, '\n');
+    } else {
+        list_append(&x->code, 0xc3);
+    }
+}
+
+/* After the last function. */
+static void x64_end(struct x64 *x)
+{
+    if(x->to) {
+        if(ir_prints(x->ir)) {
+            emit_lit(x->to,
+                     "\t.section .rodata\n.Lfmt:\n\t.asciz \"%llu\\n\"\n");
+        }
+        emit_lit(x->to, "\t.section .note.GNU-stack,\"\",@progbits\n");
+        return;
+    }
+    for(size_t i = 0; i < x->jumps.size; i++) {
+        struct jfix j = x->jumps.elems[i];
+        uint32_t rel = x->at[j.blk] - (j.at + 4);
+        memcpy(x->code.elems + j.at, &rel, 4);
+    }
+    for(size_t i = 0; i < x->calls.size; i++) {
+        struct jfix j = x->calls.elems[i];
+        uint32_t rel = x->fat[j.blk] - (j.at + 4);
+        memcpy(x->code.elems + j.at, &rel, 4);
+    }
+}
+
+/*
+ * Register allocation.
+ */
+
+static int x64_cell(struct x64 *x)
+{
+    if(x->cells.size > 0) {
+        return x->cells.elems[--x->cells.size];
+    }
+    return x->ncells++;
+}
+
+/* Hand out a register, spilling the deepest value if there's none
+ * left. Values `keep1` and `keep2` stay where they are. */
+static int x64_alloc(struct x64 *x, uint32_t keep1, uint32_t keep2)
+{
+    int victim = -1;
+    for(int i = 0; i < NPOOL; i++) {
+        int r = pool[i];
+        uint32_t v = x->owner[r];
+        if(v == IR_NOREG) {
+            return r;
+        }
+        if(v == keep1 || v == keep2) {
+            continue;
+        }
+        if(victim < 0 || x->slot[v] < x->slot[x->owner[victim]]) {
+            victim = r;
+        }
+    }
+
+    uint32_t v = x->owner[victim];
+    x->loc[v] = (struct loc){ .reg = -1, .cell = x64_cell(x) };
+    x64_op(x, X_MOV, R(victim), x->loc[v]);
+    x->owner[victim] = IR_NOREG;
+    return victim;
+}
+
+/* Give `v` register `r`, and drop it on the spot if nobody reads it. */
+static void x64_def(struct x64 *x, uint32_t v, int r, int32_t slot)
+{
+    x->loc[v] = R(r);
+    x->slot[v] = slot;
+    x->owner[r] = x->uses[v] > 0 ? v : IR_NOREG;
+}
+
+/* Let go of `v` if that was its last use. */
+static void x64_release(struct x64 *x, uint32_t v)
+{
+    if(x->uses[v] > 0) {
+        return;
+    }
+    struct loc *l = &x->loc[v];
+    if(l->reg >= 0) {
+        x->owner[l->reg] = IR_NOREG;
+    } else {
+        list_append(&x->cells, l->cell);
+    }
+    l->reg = -1;
+}
+
+/* `dst = imm op b`, for binops whose `a` is an immediate. */
+static void x64_binop_imm(struct x64 *x, const irins_t *in)
+{
+    uint32_t b = in->b;
+    x->uses[b]--;
+    int64_t v = in->imm.i;
+    if(x->loc[b].reg >= 0 && x->uses[b] == 0 && v >= INT32_MIN &&
+       v <= INT32_MAX) {
+        /* `b` is dying in a register, do it right there */
+        int rd = x->loc[b].reg;
+        if(in->op == IR_MUL) {
+            x64_imul_imm(x, (int32_t)v, rd);
+        } else {
+            if(in->op == IR_SUB) {
+                x64_neg(x, rd);
+            }
+            x64_op_imm(x, X_ADD, (int32_t)v, R(rd));
+        }
+        x->loc[b].reg = -1;
+        x64_def(x, in->dst, rd, in->depth - 1);
+        return;
+    }
+    int rd = x64_alloc(x, b, IR_NOREG);
+    x64_imm(x, in->imm.i, rd);
+    int op = in->op == IR_ADD ? X_ADD : in->op == IR_SUB ? X_SUB : X_IMUL;
+    x64_op(x, op, x->loc[b], R(rd));
+    x64_release(x, b);
+    x64_def(x, in->dst, rd, in->depth - 1);
+}
+
+static void x64_binop(struct x64 *x, const irins_t *in)
+{
+    uint32_t a = in->a, b = in->b;
+    if(a == IR_NOREG) {
+        x64_binop_imm(x, in);
+        return;
+    }
+    x->uses[a]--;
+    x->uses[b]--;
+
+    /* `a` is the left-hand side, overwrite it if it's dying anyway */
+    bool reuse = x->loc[a].reg >= 0 && x->uses[a] == 0;
+    int rd;
+    if(reuse) {
+        rd = x->loc[a].reg;
+    } else {
+        rd = x64_alloc(x, a, b);
+        x64_op(x, X_MOV, x->loc[a], R(rd));
+    }
+    int op = in->op == IR_ADD ? X_ADD : in->op == IR_SUB ? X_SUB : X_IMUL;
+    x64_op(x, op, x->loc[b], R(rd));
+
+    /* if `rd` was `a`'s, it's the result's now */
+    if(reuse) {
+        x->loc[a].reg = -1;
+    } else {
+        x64_release(x, a);
+    }
+    if(b != a) {
+        x64_release(x, b);
+    }
+    x64_def(x, in->dst, rd, in->depth - 2);
+}
+
+static void x64_div(struct x64 *x, const irins_t *in)
+{
+    uint32_t a = in->a, b = in->b;
+    if(a == IR_NOREG) {
+        x64_imm(x, in->imm.i, RAX);
+    } else {
+        x64_op(x, X_MOV, x->loc[a], R(RAX));
+    }
+    int ty = width_op(x->width, in);
+    x64_idiv(x, ty, x->loc[b]);
+
+    x->uses[b]--;
+    if(a != IR_NOREG) {
+        x->uses[a]--;
+    }
+    x64_release(x, b);
+    if(a != IR_NOREG && a != b) {
+        x64_release(x, a);
+    }
+    /* 32 bits come back extended, like a narrow result */
+    int rd = x64_alloc(x, IR_NOREG, IR_NOREG);
+    x64_ext(x, ty, R(RAX), rd);
+    x64_def(x, in->dst, rd, in->depth - (a == IR_NOREG ? 1 : 2));
+}
+
+/* Move `v` into scratch register `reg` and count the use. */
+static void x64_use(struct x64 *x, uint32_t v, int reg)
+{
+    x64_op(x, X_MOV, x->loc[v], R(reg));
+    x->uses[v]--;
+    x64_release(x, v);
+}
+
+/* Condition that's true if `a OP b`, after comparing `a` to `b`,
+ * unsigned if `uns`. */
+static int x64_cc(int op, bool uns)
+{
+    switch(op) {
+    case IR_EQ:
+        return CC_E;
+    case IR_NE:
+        return CC_NE;
+    case IR_LT:
+        return uns ? CC_B : CC_L;
+    case IR_LE:
+        return uns ? CC_BE : CC_LE;
+    case IR_GT:
+        return uns ? CC_A : CC_G;
+    default:
+        return uns ? CC_AE : CC_GE;
+    }
+}
+
+/* Same, after comparing `b` to `a`. */
+static int x64_cc_swap(int cc)
+{
+    switch(cc) {
+    case CC_L:
+        return CC_G;
+    case CC_LE:
+        return CC_GE;
+    case CC_G:
+        return CC_L;
+    case CC_GE:
+        return CC_LE;
+    case CC_B:
+        return CC_A;
+    case CC_BE:
+        return CC_AE;
+    case CC_A:
+        return CC_B;
+    case CC_AE:
+        return CC_BE;
+    default:
+        return cc;
+    }
+}
+
+/* Whether the result of comparison `ins[i]` only goes to the `jnz`
+ * right after it, so the flags are enough. */
+static bool x64_flags_only(struct x64 *x, size_t i)
+{
+    const ir_t *ir = x->ir;
+    uint32_t v = ir->ins[i].dst;
+    if(x->uses[v] != 1) {
+        return false;
+    }
+    /* constants (from the optimizer) leave the flags alone */
+    for(i++; i < ir->size; i++) {
+        int op = ir->ins[i].op;
+        if(op == IR_JNZ) {
+            return ir->ins[i].a == v;
+        }
+        if(ir_has_code(op) && op != IR_ICONST && op != IR_UCONST) {
+            return false;
+        }
+    }
+    return false;
+}
+
+static void x64_cmp(struct x64 *x, const irins_t *in, bool flags_only)
+{
+    uint32_t a = in->a, b = in->b;
+    int cc = x64_cc(in->op, in->uns);
+    int64_t v = in->imm.i;
+    if(a == IR_NOREG && v >= INT32_MIN && v <= INT32_MAX) {
+        x64_op_imm(x, X_CMP, (int32_t)v, x->loc[b]);
+        cc = x64_cc_swap(cc);
+    } else {
+        struct loc la = R(RAX);
+        if(a == IR_NOREG) {
+            x64_imm(x, v, RAX);
+        } else if(x->loc[a].reg >= 0) {
+            la = x->loc[a];
+        } else {
+            x64_op(x, X_MOV, x->loc[a], R(RAX));
+        }
+        x64_op(x, X_CMP, x->loc[b], la);
+    }
+
+    x->uses[b]--;
+    x64_release(x, b);
+    if(a != IR_NOREG) {
+        x->uses[a]--;
+        if(a != b) {
+            x64_release(x, a);
+        }
+    }
+    if(flags_only) {
+        x->flags = in->dst;
+        x->cc = cc;
+        return;
+    }
+    /* spilling only moves, the flags stay */
+    int rd = x64_alloc(x, IR_NOREG, IR_NOREG);
+    x64_setcc(x, cc, rd);
+    x64_def(x, in->dst, rd, in->depth - (a == IR_NOREG ? 1 : 2));
+}
+
+/* Home of the `k`-th phi of a block. */
+static struct loc x64_home(int k)
+{
+    if(k < NPOOL) {
+        return R(pool[k]);
+    }
+    return (struct loc){ .reg = -1, .cell = k - NPOOL };
+}
+
+static bool x64_same(struct loc p, struct loc q)
+{
+    return p.reg == q.reg && (p.reg >= 0 || p.cell == q.cell);
+}
+
+/* Moves of what the block at hand hands the phis of block `to`, into
+ * their homes, put in `m`. Returns how many there are. */
+static int x64_edge(struct x64 *x, uint32_t to, struct move *m)
+{
+    const ir_t *ir = x->ir;
+    int n = 0, k = 0;
+    for(size_t i = ir->blocks[to] + 1;
+        i < ir->size && ir->ins[i].op == IR_PHI; i++, k++) {
+        const irins_t *phi = &ir->ins[i];
+        uint32_t v = phi->imm.blk[0] == x->blk ? phi->a : phi->b;
+        x->uses[v]--;
+        struct loc h = x64_home(k);
+        if(!x64_same(x->loc[v], h)) {
+            m[n++] = (struct move){ x->loc[v], h };
+        }
+    }
+    return n;
+}
+
+/* Do the `n` moves of `m` as if all at once. */
+static void x64_moves(struct x64 *x, struct move *m, int n)
+{
+    while(n > 0) {
+        /* a move whose destination nobody else reads can go now */
+        int ready = -1;
+        for(int i = 0; i < n && ready < 0; i++) {
+            ready = i;
+            for(int j = 0; j < n; j++) {
+                if(j != i && x64_same(m[j].src, m[i].dst)) {
+                    ready = -1;
+                    break;
+                }
+            }
+        }
+        if(ready >= 0) {
+            struct loc src = m[ready].src;
+            if(src.reg < 0 && m[ready].dst.reg < 0) {
+                x64_op(x, X_MOV, src, R(RAX));
+                src = R(RAX);
+            }
+            x64_op(x, X_MOV, src, m[ready].dst);
+            m[ready] = m[--n];
+            continue;
+        }
+        /* all that's left are cycles: take one source out of the way */
+        struct loc src = m[0].src;
+        x64_op(x, X_MOV, src, R(RCX));
+        for(int j = 0; j < n; j++) {
+            if(x64_same(m[j].src, src)) {
+                m[j].src = R(RCX);
+            }
+        }
+    }
+}
+
+/* Whether `ins[i + 1]` starts block `blk`, so there's no need to jump. */
+static bool x64_next(struct x64 *x, size_t i, uint32_t blk)
+{
+    const ir_t *ir = x->ir;
+    return i + 1 < ir->size && ir->ins[i + 1].op == IR_LABEL &&
+           ir->ins[i + 1].imm.blk[0] == blk;
+}
+
+static void x64_jnz(struct x64 *x, const irins_t *in, size_t i,
+                    struct move *m)
+{
+    int cc = CC_NE;
+    if(in->a == x->flags) {
+        cc = x->cc;
+        x->flags = IR_NOREG;
+    } else {
+        x64_op_imm(x, X_CMP, 0, x->loc[in->a]);
+    }
+    x->uses[in->a]--;
+
+    uint32_t yes = in->imm.blk[0], no = in->imm.blk[1];
+    int ny = x64_edge(x, yes, m);
+    int nn = x64_edge(x, no, m + ny);
+    if(nn == 0) {
+        x64_jmp(x, cc ^ 1, no);
+        x64_moves(x, m, ny);
+        if(!x64_next(x, i, yes)) {
+            x64_jmp(x, -1, yes);
+        }
+    } else if(ny == 0) {
+        x64_jmp(x, cc, yes);
+        x64_moves(x, m + ny, nn);
+        if(!x64_next(x, i, no)) {
+            x64_jmp(x, -1, no);
+        }
+    } else {
+        uint32_t fwd = x64_jcc_fwd(x, cc ^ 1);
+        x64_moves(x, m, ny);
+        x64_jmp(x, -1, yes);
+        x64_tramp(x, fwd);
+        x64_moves(x, m + ny, nn);
+        if(!x64_next(x, i, no)) {
+            x64_jmp(x, -1, no);
+        }
+    }
+}
+
+/* Call the function op `in` calls, with the arguments from the
+ * IR_ARGs before it. */
+static void x64_callf(struct x64 *x, const irins_t *in)
+{
+    const irfunc_t *f = &x->ir->funcs[in->imm.func.fn];
+    int n = (int)f->nparams;
+    x->args.size -= (size_t)n;
+    const uint32_t *args = x->args.elems + x->args.size;
+
+    /* the ones that don't fit in registers go on the stack, the last
+     * one first, and %rsp stays 16-byte aligned */
+    int pushed = n > NARGREGS ? n - NARGREGS : 0;
+    if(pushed % 2 != 0) {
+        x64_op_imm(x, X_SUB, 8, R(RSP));
+    }
+    for(int k = n; k-- > NARGREGS;) {
+        x64_push_loc(x, x->loc[args[k]]);
+    }
+    for(int k = 0; k < n && k < NARGREGS; k++) {
+        x64_op(x, X_MOV, x->loc[args[k]], R(argregs[k]));
+    }
+    for(int k = 0; k < n; k++) {
+        x->uses[args[k]]--;
+        x64_release(x, args[k]);
+    }
+    x64_callf_insn(x, in->imm.func.fn);
+    if(pushed > 0) {
+        x64_op_imm(x, X_ADD, 8 * (pushed + pushed % 2), R(RSP));
+    }
+    if(in->dst != IR_NOREG) {
+        int rd = x64_alloc(x, IR_NOREG, IR_NOREG);
+        x64_ext(x, f->ret, R(RAX), rd);
+        x64_def(x, in->dst, rd, in->depth);
+    }
+}
+
+/* Return what the function op `in` calls returns, with the arguments
+ * from the IR_ARGs before it. The function at hand starts over with
+ * them as its parameters; any other is jumped to once the frame is
+ * down, if its parameters fit in registers. */
+static void x64_tail(struct x64 *x, const irins_t *in, struct move *m)
+{
+    uint32_t fn = in->imm.func.fn;
+    const irfunc_t *f = &x->ir->funcs[fn];
+    int n = (int)f->nparams;
+    if(fn != x->fn && n > NARGREGS) {
+        /* the caller only made room for the arguments we got */
+        x64_callf(x, in);
+        x64_jmp_ret(x);
+        return;
+    }
+    x->args.size -= (size_t)n;
+    const uint32_t *args = x->args.elems + x->args.size;
+    /* the places parameters come in hold no values, those of the ones
+     * on the stack included, so any order does */
+    for(int k = 0; k < n; k++) {
+        m[k] = (struct move){ x->loc[args[k]], x64_param(k) };
+        x->uses[args[k]]--;
+    }
+    x64_moves(x, m, n);
+    if(fn == x->fn) {
+        if(x->to) {
+            emit_lit(x->to, "\tjmp .Ltop");
+            emit_u64(x->to, fn);
+            emit_char(x->to, '\n');
+        } else {
+            list_append(&x->code, 0xe9);
+            x64_u32(x, x->top - ((uint32_t)x->code.size + 4));
+        }
+        return;
+    }
+    x64_leave(x);
+    if(x->to) {
+        emit_lit(x->to, "\tjmp ");
+        cg_fsym(x->to, x->ir, f);
+        emit_char(x->to, '\n');
+    } else {
+        list_append(&x->code, 0xe9);
+        list_append(&x->calls, ((struct jfix){ (uint32_t)x->code.size, fn }));
+        x64_u32(x, 0);
+    }
+}
+
+/* Start function `fn`, nothing allocated yet. */
+static void x64_begin(struct x64 *x, uint32_t fn)
+{
+    x->fn = fn;
+    for(int r = 0; r < 16; r++) {
+        x->owner[r] = IR_NOREG;
+    }
+    x->cells.size = 0;
+    x->ncells = x->nhome;
+    x->args.size = 0;
+    x->flags = IR_NOREG;
+
+    /* Only values on the stack are alive, plus the result of the op at
+     * hand, so that many cells are always enough. Keep %rsp 16-byte
+     * aligned for calls: the pushes leave it at 8 mod 16. */
+    int32_t frame =
+        ((int32_t)x->ir->funcs[fn].maxdepth + 1 + x->nhome) * 8;
+    frame += (frame + 8) % 16;
+    x64_prelude(x, frame);
+}
+
+static void x64_gen(struct x64 *x)
+{
+    const ir_t *ir = x->ir;
+    size_t nv = size_max(ir->nvregs, 1);
+    x->loc = zcalloc(nv, sizeof(*x->loc));
+    x->uses = zcalloc(nv, sizeof(*x->uses));
+    x->width = width_infer(ir);
+    x->slot = zcalloc(nv, sizeof(*x->slot));
+    x->at = zcalloc(size_max(ir->nblocks, 1), sizeof(*x->at));
+    x->fat = zcalloc(size_max(ir->nfuncs, 1), sizeof(*x->fat));
+    struct move *m = zcalloc(2 * ((size_t)ir->maxdepth + 1), sizeof(*m));
+    int nphi = 0;
+    for(size_t i = 0; i < ir->size; i++) {
+        const irins_t *in = &ir->ins[i];
+        nphi = in->op == IR_PHI ? nphi + 1 : 0;
+        x->nhome = nphi - NPOOL > x->nhome ? nphi - NPOOL : x->nhome;
+        if(!ir_has_code(in->op)) {
+            continue;
+        }
+        if(in->a != IR_NOREG) {
+            x->uses[in->a]++;
+        }
+        if(in->b != IR_NOREG) {
+            x->uses[in->b]++;
+        }
+    }
+
+    if(x->to) {
+        emit_lit(x->to, "\t.text\n");
+    }
+    x64_begin(x, 0);
+
+    for(size_t i = 0; i < ir->size; i++) {
+        const irins_t *in = &ir->ins[i];
+        switch(in->op) {
+        case IR_ICONST:
+        case IR_UCONST: {
+            int rd = x64_alloc(x, IR_NOREG, IR_NOREG);
+            x64_imm(x, in->imm.i, rd);
+            x64_def(x, in->dst, rd, in->depth);
+            break;
+        }
+        case IR_ADD:
+        case IR_SUB:
+        case IR_MUL:
+            x64_binop(x, in);
+            break;
+        case IR_EQ:
+        case IR_NE:
+        case IR_LT:
+        case IR_LE:
+        case IR_GT:
+        case IR_GE:
+            x64_cmp(x, in, x64_flags_only(x, i));
+            break;
+        case IR_DIV:
+            x64_div(x, in);
+            break;
+        case IR_DUMP:
+            x64_fmt_arg(x);
+            x64_use(x, in->a, RSI);
+            x64_zero_eax(x);
+            x64_call(x, (const uint8_t *)"printf", 6, (const void *)printf);
+            break;
+        case IR_CALL: {
+            const void *addr = NULL;
+            if(!x->to && !(addr = x->resolve(x->ctx, in))) {
+                x->err = 1;
+            }
+            x64_zero_eax(x);
+            x64_call(x, ir_sym(ir, in), in->imm.sym.len, addr);
+            int rd = x64_alloc(x, IR_NOREG, IR_NOREG);
+            x64_op(x, X_MOV, R(RAX), R(rd));
+            x64_def(x, in->dst, rd, in->depth);
+            break;
+        }
+        case IR_RET:
+            if(in->a != IR_NOREG) {
+                x64_use(x, in->a, RAX);
+            }
+            x64_jmp_ret(x);
+            break;
+        case IR_FUNC:
+            x64_epilogue(x);
+            x64_begin(x, in->imm.func.fn);
+            x->blk = in->imm.func.blk;
+            x->nphi = 0;
+            break;
+        case IR_PARAM: {
+            int rd = x64_alloc(x, IR_NOREG, IR_NOREG);
+            x64_ext(x, ir->funcs[x->fn].params[in->imm.i],
+                    x64_param((int)in->imm.i), rd);
+            x64_def(x, in->dst, rd, in->depth);
+            break;
+        }
+        case IR_EXT: {
+            int rd = x64_alloc(x, in->a, IR_NOREG);
+            x64_ext(x, (int)in->imm.i, x->loc[in->a], rd);
+            x->uses[in->a]--;
+            x64_release(x, in->a);
+            x64_def(x, in->dst, rd, in->depth);
+            break;
+        }
+        case IR_ARG:
+            list_append(&x->args, in->a);
+            break;
+        case IR_CALLF:
+            x64_callf(x, in);
+            break;
+        case IR_TAIL:
+            x64_tail(x, in, m);
+            break;
+        case IR_LABEL:
+            /* nothing but the phis comes in */
+            x->blk = in->imm.blk[0];
+            x->nphi = 0;
+            for(int r = 0; r < 16; r++) {
+                x->owner[r] = IR_NOREG;
+            }
+            x->cells.size = 0;
+            x->ncells = x->nhome;
+            x64_label(x, x->blk);
+            break;
+        case IR_PHI: {
+            struct loc h = x64_home(x->nphi);
+            x->loc[in->dst] = h;
+            x->slot[in->dst] = x->nphi++;
+            if(h.reg >= 0) {
+                x->owner[h.reg] = x->uses[in->dst] > 0 ? in->dst : IR_NOREG;
+            }
+            break;
+        }
+        case IR_JMP: {
+            int n = x64_edge(x, in->imm.blk[0], m);
+            x64_moves(x, m, n);
+            if(!x64_next(x, i, in->imm.blk[0])) {
+                x64_jmp(x, -1, in->imm.blk[0]);
+            }
+            break;
+        }
+        case IR_JNZ:
+            x64_jnz(x, in, i, m);
+            break;
+        default:
+            /* IR_NOP and the stack shuffles: nothing to do */
+            break;
+        }
+    }
+    x64_epilogue(x);
+    x64_end(x);
+
+    free(x->loc);
+    free(x->uses);
+    free(x->width);
+    free(x->slot);
+    free(x->at);
+    free(x->fat);
+    free(x->args.elems);
+    free(x->calls.elems);
+    free(m);
+    free(x->cells.elems);
+    free(x->fixups.elems);
+    free(x->jumps.elems);
+}
+
+/* print x86-64 assembly for `ir` to `to` */
+void cg_x64(const ir_t *ir, emit_t *to)
+{
+    struct x64 x = { 0 };
+    x.ir = ir;
+    x.to = to;
+    x64_gen(&x);
+}
+
+/* Assemble `ir` into x86-64 machine code for an `int64_t (void)`
+ * function, put in `*code` (freed by the caller), `*size` bytes long.
+ * `resolve` gives the address of every function called.
+ * Returns nonzero if any of those can't be resolved. */
+int cg_x64_code(const ir_t *ir, cg_resolve_fn resolve, void *ctx,
+                uint8_t **code, size_t *size)
+{
+    struct x64 x = { 0 };
+    x.ir = ir;
+    x.resolve = resolve;
+    x.ctx = ctx;
+    x64_gen(&x);
+    *code = x.code.elems;
+    *size = x.code.size;
+    return x.err;
+}
@@ -0,0 +1,296 @@
+/*
+ * Copyright (C) 2025 therealblue24.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Stack-effect analysis.
+ */
+#include "depth.h"
+#include <inttypes.h>
+
+/* An `if` or `while` that hasn't seen its `end` yet. */
+struct dctl {
+    int kind; /* TOK_IF, TOK_THEN, TOK_ELSE, TOK_WHILE or TOK_DO, the
+               * last of its keywords so far */
+    uint32_t tok; /* the `if` or `while` */
+    int32_t depth; /* going in */
+    int32_t skip; /* THEN, DO: depth the way past the branch takes
+                   * along; ELSE: the way out of `then` */
+    bool skip_live; /* if it's ever taken */
+};
+
+/* Checker state. */
+struct dc {
+    lex_t *lex;
+    const irfunc_t *funcs;
+    uint32_t nfuncs;
+    const intern_t *names; /* of `funcs`, see `ir_t` */
+    int32_t depth, maxdepth;
+    bool dead; /* after `ret`, until a way in that's taken */
+    bool deep; /* overflow of this function reported */
+    LIST(struct dctl) ctl;
+    int failed;
+};
+
+/* Report a problem at token `tok`, and keep going. */
+#define DEPTH_ERR(c, tok, ...)                                      \
+    do {                                                            \
+        LEX_ERR((c)->lex, (size_t)((tok)->raw - (c)->lex->buf),     \
+                (tok)->range, __VA_ARGS__);                         \
+        (c)->failed = 1;                                            \
+    } while(0)
+
+/* Function called by token `it`, or NULL if it calls something else. */
+static const irfunc_t *depth_callee(const struct dc *c, const token_t *it)
+{
+    return c->names ? ir_lookup(c->funcs, c->names, it->raw, it->range)
+                    : NULL;
+}
+
+/* An op at token `tok` that takes `pops` values off the stack and puts
+ * `pushes` back. An underflow gets reported, and counting goes on from
+ * as many values as were needed. */
+static void depth_effect(struct dc *c, const token_t *tok, int32_t pops,
+                         int32_t pushes)
+{
+    if(c->depth < pops) {
+        DEPTH_ERR(c, tok, "stack underflow");
+        c->depth = pops;
+    }
+    c->depth += pushes - pops;
+    if(c->depth > c->maxdepth) {
+        c->maxdepth = c->depth;
+    }
+    if(c->depth > DEPTH_MAX && !c->deep) {
+        DEPTH_ERR(c, tok, "stack overflow: more than %d values", DEPTH_MAX);
+        c->deep = true;
+    }
+}
+
+/* Where a way in at depth `depth`, `live` if it's ever taken, meets
+ * the way here. */
+static void depth_join(struct dc *c, int32_t depth, bool live)
+{
+    if(live) {
+        c->depth = depth;
+        c->dead = false;
+    } else {
+        c->dead = true;
+    }
+}
+
+/* Report keyword `tok` turning up `why`. */
+static void depth_misplaced(struct dc *c, const token_t *tok,
+                            const char *why)
+{
+    DEPTH_ERR(c, tok, "`%.*s` %s", (int)tok->range, tok->raw, why);
+}
+
+/* Control flow keyword `it`, token number `tok`. Misplaced ones are
+ * reported and skipped. */
+static void depth_control(struct dc *c, const token_t *it, uint32_t tok)
+{
+    struct dctl *k = c->ctl.size > 0 ? &c->ctl.elems[c->ctl.size - 1]
+                                     : NULL;
+    int kind = k ? k->kind : -1;
+
+    switch(it->toktype) {
+    case TOK_IF:
+    case TOK_WHILE: {
+        struct dctl n = { .kind = (int)it->toktype,
+                          .tok = tok,
+                          .depth = c->depth };
+        list_append(&c->ctl, n);
+        return;
+    }
+    case TOK_THEN:
+    case TOK_DO: {
+        bool loop = it->toktype == TOK_DO;
+        if(kind != (loop ? TOK_WHILE : TOK_IF)) {
+            depth_misplaced(c, it, loop ? "without `while`" : "without `if`");
+            return;
+        }
+        depth_effect(c, it, 1, 0);
+        if(loop && !c->dead && k->depth != c->depth) {
+            DEPTH_ERR(c, it,
+                      "unbalanced loop: the stack is %" PRId32
+                      " deep going in and %" PRId32 " after the condition",
+                      k->depth, c->depth);
+        }
+        k->kind = (int)it->toktype;
+        k->skip = c->depth;
+        k->skip_live = !c->dead;
+        return;
+    }
+    case TOK_ELSE: {
+        if(kind != TOK_THEN) {
+            depth_misplaced(c, it, "without `if ... then`");
+            return;
+        }
+        int32_t depth = c->depth;
+        bool live = !c->dead;
+        depth_join(c, k->skip, k->skip_live);
+        k->kind = TOK_ELSE;
+        k->skip = depth;
+        k->skip_live = live;
+        return;
+    }
+    case TOK_END: {
+        if(kind != TOK_THEN && kind != TOK_ELSE && kind != TOK_DO) {
+            depth_misplaced(c, it,
+                            kind == TOK_IF      ? "before `then`"
+                            : kind == TOK_WHILE ? "before `do`"
+                                                : "without `if` or `while`");
+            /* `end` also closes what's open, so it doesn't stay so */
+            c->ctl.size -= k != NULL;
+            return;
+        }
+        struct dctl e = *k;
+        c->ctl.size--;
+        if(kind == TOK_DO) {
+            if(!c->dead && e.depth != c->depth) {
+                DEPTH_ERR(c, it,
+                          "unbalanced loop: the stack is %" PRId32
+                          " deep going in and %" PRId32 " after the body",
+                          e.depth, c->depth);
+            }
+            depth_join(c, e.skip, e.skip_live);
+            return;
+        }
+        if(!c->dead && e.skip_live && e.skip != c->depth) {
+            DEPTH_ERR(c, it,
+                      "unbalanced branches: the stack is %" PRId32
+                      " deep one way and %" PRId32 " the other",
+                      e.skip, c->depth);
+        }
+        /* the way past `then` (or out of it) wins */
+        if(e.skip_live || c->dead) {
+            depth_join(c, e.skip, e.skip_live);
+        }
+        return;
+    }
+    default:
+        return;
+    }
+}
+
+/* Check function `fn`. */
+static void depth_func(struct dc *c, uint32_t fn)
+{
+    const irfunc_t *f = &c->funcs[fn];
+    lex_t *lex = c->lex;
+    /* the parameters are on the stack coming in */
+    c->depth = c->maxdepth = (int32_t)f->nparams;
+    c->dead = c->deep = false;
+    c->ctl.size = 0;
+
+    uint32_t nextfn = 1; /* next function `main` skips */
+    tokiter_t iter;
+    lex_iter_at(lex, &iter, f->body);
+    token_t it;
+    while(iter.i < f->end && lex_iter(lex, &iter, &it)) {
+        uint32_t tok = (uint32_t)(iter.i - 1);
+        switch(it.toktype) {
+        case TOK_ADD:
+        case TOK_SUB:
+        case TOK_MUL:
+        case TOK_DIV:
+        case TOK_EQ:
+        case TOK_NE:
+        case TOK_LT:
+        case TOK_LE:
+        case TOK_GT:
+        case TOK_GE:
+            depth_effect(c, &it, 2, 1);
+            break;
+        case TOK_DUP:
+            depth_effect(c, &it, 1, 2);
+            break;
+        case TOK_DROP:
+        case TOK_DUMP:
+            depth_effect(c, &it, 1, 0);
+            break;
+        case TOK_DROPALL:
+            depth_effect(c, &it, c->depth, 0);
+            break;
+        case TOK_SWAP:
+            depth_effect(c, &it, 2, 2);
+            break;
+        case TOK_OVER:
+            depth_effect(c, &it, 2, 3);
+            break;
+        case TOK_RET:
+            /* functions that return nothing just leave */
+            depth_effect(c, &it, f->ret != IRT_NONE, 0);
+            c->depth = 0;
+            c->dead = true;
+            break;
+        case TOK_NUM_INT:
+        case TOK_NUM_INTU:
+            depth_effect(c, &it, 0, 1);
+            break;
+        case TOK_SPECIAL_LIT: {
+            const irfunc_t *callee = depth_callee(c, &it);
+            if(callee) {
+                depth_effect(c, &it, (int32_t)callee->nparams,
+                             callee->ret != IRT_NONE);
+            } else {
+                depth_effect(c, &it, 0, 1);
+            }
+            break;
+        }
+        case TOK_FUNC:
+            /* only `main` runs into these, and they're checked on
+             * their own */
+            if(nextfn < c->nfuncs) {
+                lex_iter_at(lex, &iter, c->funcs[nextfn++].end + 1);
+            }
+            break;
+        case TOK_IF:
+        case TOK_THEN:
+        case TOK_ELSE:
+        case TOK_WHILE:
+        case TOK_DO:
+        case TOK_END:
+            depth_control(c, &it, tok);
+            break;
+        default:
+            /* there's no telling what comes after */
+            DEPTH_ERR(c, &it, "unsupported op");
+            return;
+        }
+    }
+
+    for(size_t k = c->ctl.size; k-- > 0;) {
+        token_t open;
+        lex_tok(lex, c->ctl.elems[k].tok, &open);
+        DEPTH_ERR(c, &open, "`%.*s` without `end`", (int)open.range,
+                  open.raw);
+    }
+    /* running into the `end` of a function returns */
+    if(fn > 0 && !c->dead && f->ret != IRT_NONE) {
+        lex_tok(lex, f->end, &it);
+        depth_effect(c, &it, 1, 0);
+    }
+}
+
+/* Check the stack effects of `funcs` (`main` first, with the bodies of
+ * the others in it skipped), whose tokens are in `lex` and whose names
+ * are in `names` (see `ir_t`, NULL if there's only `main`), and set
+ * their `maxdepth`. Problems get reported through `lex`.
+ * Returns nonzero if there were any. */
+int depth_check(lex_t *lex, irfunc_t *funcs, uint32_t nfuncs,
+                const intern_t *names)
+{
+    struct dc c = {
+        .lex = lex, .funcs = funcs, .nfuncs = nfuncs, .names = names
+    };
+    for(uint32_t fn = 0; fn < nfuncs; fn++) {
+        depth_func(&c, fn);
+        funcs[fn].maxdepth = (uint32_t)c.maxdepth;
+    }
+    free(c.ctl.elems);
+    return c.failed;
+}
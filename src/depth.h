@@ -0,0 +1,37 @@
+/*
+ * Copyright (C) 2025 therealblue24.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Header file for the stack-effect analysis.
+ *
+ * Every op has a fixed stack effect, and the depth has to agree where
+ * control flow meets, so the depth at every token is known before
+ * anything runs. One pass over the tokens works it out, function by
+ * function, and reports every underflow, overflow and unbalanced
+ * branch or loop it finds, not just the first. What comes after gets
+ * to assume a program that passed: the IR builder and the VM check
+ * nothing themselves, and the VM's stack is exactly as deep as the
+ * program needs.
+ */
+#ifndef DEPTH_H_
+#define DEPTH_H_
+
+#include "util.h"
+#include "lex.h"
+#include "ir.h"
+
+/* values any one stack can hold */
+#define DEPTH_MAX (64 * 1024)
+
+/* Check the stack effects of `funcs` (`main` first, with the bodies of
+ * the others in it skipped), whose tokens are in `lex` and whose names
+ * are in `names` (see `ir_t`, NULL if there's only `main`), and set
+ * their `maxdepth`. Problems get reported through `lex`.
+ * Returns nonzero if there were any. */
+int depth_check(lex_t *lex, irfunc_t *funcs, uint32_t nfuncs,
+                const intern_t *names);
+
+#endif /* DEPTH_H_ */
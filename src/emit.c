@@ -0,0 +1,207 @@
+/*
+ * Copyright (C) 2025 therealblue24.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Buffered output: a big buffer and write(2), or a mapped file.
+ */
+#include "emit.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+/* first size of a mapped output file, doubled as needed */
+#define EMIT_MAPSZ (1024 * 1024)
+
+#define D10(x) x "0" x "1" x "2" x "3" x "4" x "5" x "6" x "7" x "8" x "9"
+/* "00" to "99" */
+const char emit_digits[200] = D10("0") D10("1") D10("2") D10("3") D10("4")
+    D10("5") D10("6") D10("7") D10("8") D10("9");
+#undef D10
+
+struct emit_regname emit_regs[EMIT_NREGS];
+
+/* Fill `emit_regs` in, once. */
+static void emit_regs_init(void)
+{
+    static bool done = false;
+    if(done) {
+        return;
+    }
+    for(int i = 0; i < EMIT_NREGS; i++) {
+        struct emit_regname *r = &emit_regs[i];
+        r->len = (uint8_t)snprintf(r->s, sizeof(r->s), "%%s%d", i);
+    }
+    done = true;
+}
+
+/* Write all of `iov` to `e->fd`, retrying short writes. */
+static void emit_writev(emit_t *e, struct iovec *iov, int n)
+{
+    while(n > 0 && !e->err) {
+        ssize_t w = writev(e->fd, iov, n);
+        if(w < 0) {
+            if(errno != EINTR) {
+                e->err = errno;
+            }
+            continue;
+        }
+        e->flushed += (size_t)w;
+        /* skip what went out */
+        while(n > 0 && (size_t)w >= iov->iov_len) {
+            w -= (ssize_t)iov->iov_len;
+            iov++;
+            n--;
+        }
+        if(n > 0) {
+            iov->iov_base = (uint8_t *)iov->iov_base + w;
+            iov->iov_len -= (size_t)w;
+        }
+    }
+}
+
+/* Emit to file descriptor `fd`, which stays open. */
+void emit_init_fd(emit_t *e, int fd)
+{
+    emit_regs_init();
+    memset(e, 0, sizeof(*e));
+    e->fd = fd;
+    e->cap = EMIT_BUFSZ;
+    e->buf = zalloc(e->cap);
+}
+
+/* Map `cap` bytes of the output file.
+ * Returns nonzero on failure. */
+static int emit_map(emit_t *e, size_t cap)
+{
+    if(ftruncate(e->fd, (off_t)cap)) {
+        return 1;
+    }
+    void *map = mmap(NULL, cap, PROT_READ | PROT_WRITE, MAP_SHARED, e->fd, 0);
+    if(map == MAP_FAILED) {
+        return 1;
+    }
+    e->buf = map;
+    e->cap = cap;
+    return 0;
+}
+
+/* Create the output file `path`.
+ * Returns the file descriptor, -1 on failure. */
+static int emit_create(const char *path)
+{
+    return open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+}
+
+/* Emit to a new file at `path`.
+ * Returns nonzero on failure, with errno set. */
+int emit_open(emit_t *e, const char *path)
+{
+    int fd = emit_create(path);
+    if(fd < 0) {
+        return 1;
+    }
+    emit_init_fd(e, fd);
+    e->owned = true;
+    return 0;
+}
+
+/* Emit to a new file at `path`, written through a shared mapping.
+ * Falls back to `emit_open`'s buffered writes if it can't be mapped.
+ * Returns nonzero on failure, with errno set. */
+int emit_open_mapped(emit_t *e, const char *path)
+{
+    int fd = emit_create(path);
+    if(fd < 0) {
+        return 1;
+    }
+    emit_regs_init();
+    memset(e, 0, sizeof(*e));
+    e->fd = fd;
+    e->owned = true;
+    if(emit_map(e, EMIT_MAPSZ) == 0) {
+        e->mapped = true;
+        return 0;
+    }
+    /* no luck, plain writes it is */
+    (void)ftruncate(fd, 0);
+    emit_init_fd(e, fd);
+    e->owned = true;
+    return 0;
+}
+
+/* Make room for at least `n` more bytes, slow path of `emit_reserve`. */
+void emit_grow(emit_t *e, size_t n)
+{
+    if(e->mapped) {
+        size_t cap = e->cap;
+        while(cap - e->size < n) {
+            cap *= 2;
+        }
+        munmap(e->buf, e->cap);
+        if(emit_map(e, cap)) {
+            ERROR("can't grow mapped output to %zu bytes: %s", cap,
+                  strerror(errno));
+        }
+        return;
+    }
+    emit_flush(e);
+    if(n > e->cap) {
+        e->cap = n;
+        e->buf = zrealloc(e->buf, e->cap);
+    }
+}
+
+/* Write out what's buffered. Mapped output needs no flushing. */
+void emit_flush(emit_t *e)
+{
+    if(e->mapped || e->size == 0) {
+        return;
+    }
+    struct iovec iov = { e->buf, e->size };
+    emit_writev(e, &iov, 1);
+    e->size = 0;
+}
+
+/* Emit `n` bytes from `p` without going through the buffer. */
+void emit_direct(emit_t *e, const void *p, size_t n)
+{
+    if(e->mapped) {
+        emit_reserve(e, n);
+        memcpy(e->buf + e->size, p, n);
+        e->size += n;
+        return;
+    }
+    /* buffered stuff first, both in one go */
+    struct iovec iov[2] = { { e->buf, e->size }, { (void *)p, n } };
+    emit_writev(e, iov, 2);
+    e->size = 0;
+}
+
+/* Flush and close `e`.
+ * Returns nonzero if anything failed along the way, with errno set. */
+int emit_close(emit_t *e)
+{
+    if(e->mapped) {
+        munmap(e->buf, e->cap);
+        /* cut off the unused tail of the mapping */
+        if(ftruncate(e->fd, (off_t)e->size) && !e->err) {
+            e->err = errno;
+        }
+    } else {
+        emit_flush(e);
+        free(e->buf);
+    }
+    if(e->owned && close(e->fd) && !e->err) {
+        e->err = errno;
+    }
+    e->buf = NULL;
+    if(e->err) {
+        errno = e->err;
+        return 1;
+    }
+    return 0;
+}
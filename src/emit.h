@@ -0,0 +1,150 @@
+/*
+ * Copyright (C) 2025 therealblue24.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Header file for the buffered output emitter.
+ */
+#ifndef EMIT_H_
+#define EMIT_H_
+
+#include "util.h"
+
+/* size of the buffer in front of a file descriptor */
+#define EMIT_BUFSZ (256 * 1024)
+/* registers `%s0` up to this one have a precomputed name */
+#define EMIT_NREGS 1024
+
+/* Output sink. Text goes into `buf`, which is either a heap buffer
+ * flushed to `fd` with write(2)/writev(2) when full, or a shared
+ * mapping of the output file itself that grows as needed. */
+typedef struct emit {
+    uint8_t *buf;
+    size_t size, cap;
+    int fd;
+    bool owned; /* `fd` was opened by `emit_open` */
+    bool mapped; /* `buf` maps the file */
+    size_t flushed; /* bytes written out of `buf` so far */
+    int err; /* errno of the first failure, sticky */
+} emit_t;
+
+/* Name of register `i`, e.g. "%s12". */
+struct emit_regname {
+    char s[7];
+    uint8_t len;
+};
+
+extern const char emit_digits[200];
+extern struct emit_regname emit_regs[EMIT_NREGS];
+
+/* Emit to file descriptor `fd`, which stays open. */
+void emit_init_fd(emit_t *e, int fd);
+
+/* Emit to a new file at `path`.
+ * Returns nonzero on failure, with errno set. */
+int emit_open(emit_t *e, const char *path);
+
+/* Emit to a new file at `path`, written through a shared mapping.
+ * Falls back to `emit_open`'s buffered writes if it can't be mapped.
+ * Returns nonzero on failure, with errno set. */
+int emit_open_mapped(emit_t *e, const char *path);
+
+/* Make room for at least `n` more bytes, slow path of `emit_reserve`. */
+void emit_grow(emit_t *e, size_t n);
+
+/* Write out what's buffered. Mapped output needs no flushing. */
+void emit_flush(emit_t *e);
+
+/* Emit `n` bytes from `p` without going through the buffer. */
+void emit_direct(emit_t *e, const void *p, size_t n);
+
+/* Flush and close `e`.
+ * Returns nonzero if anything failed along the way, with errno set. */
+int emit_close(emit_t *e);
+
+/* Total bytes emitted. */
+static inline size_t emit_total(const emit_t *e)
+{
+    return e->flushed + e->size;
+}
+
+/* Make room for at least `n` more bytes. */
+static inline void emit_reserve(emit_t *e, size_t n)
+{
+    if(e->cap - e->size < n) {
+        emit_grow(e, n);
+    }
+}
+
+static inline void emit_bytes(emit_t *e, const void *p, size_t n)
+{
+    /* big chunks aren't worth copying around */
+    if(n >= EMIT_BUFSZ / 4 && !e->mapped) {
+        emit_direct(e, p, n);
+        return;
+    }
+    emit_reserve(e, n);
+    memcpy(e->buf + e->size, p, n);
+    e->size += n;
+}
+
+/* Emit string literal `s`, length known at compile time. */
+#define emit_lit(e, s) emit_bytes((e), "" s, sizeof(s) - 1)
+
+static inline void emit_char(emit_t *e, char c)
+{
+    emit_reserve(e, 1);
+    e->buf[e->size++] = (uint8_t)c;
+}
+
+static inline void emit_str(emit_t *e, const char *s)
+{
+    emit_bytes(e, s, strlen(s));
+}
+
+/* Emit `v` in decimal, two digits at a time. */
+static inline void emit_u64(emit_t *e, uint64_t v)
+{
+    char tmp[20];
+    char *p = tmp + sizeof(tmp);
+    while(v >= 100) {
+        p -= 2;
+        memcpy(p, emit_digits + (v % 100) * 2, 2);
+        v /= 100;
+    }
+    if(v >= 10) {
+        p -= 2;
+        memcpy(p, emit_digits + v * 2, 2);
+    } else {
+        *--p = (char)('0' + v);
+    }
+    emit_bytes(e, p, (size_t)(tmp + sizeof(tmp) - p));
+}
+
+static inline void emit_i64(emit_t *e, int64_t v)
+{
+    if(v < 0) {
+        emit_char(e, '-');
+        emit_u64(e, 0 - (uint64_t)v);
+    } else {
+        emit_u64(e, (uint64_t)v);
+    }
+}
+
+/* Emit the name of stack register `i`, "%s<i>". */
+static inline void emit_reg(emit_t *e, int i)
+{
+    if(i >= 0 && i < EMIT_NREGS) {
+        /* copy the whole slot, only keep what's needed */
+        emit_reserve(e, sizeof(emit_regs[i]));
+        memcpy(e->buf + e->size, emit_regs[i].s, sizeof(emit_regs[i]));
+        e->size += emit_regs[i].len;
+    } else {
+        emit_lit(e, "%s");
+        emit_i64(e, i);
+    }
+}
+
+#endif /* EMIT_H_ */
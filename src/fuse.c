@@ -0,0 +1,32 @@
+/*
+ * Copyright (C) 2025 therealblue24.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Superinstruction fusion: pattern names and counters.
+ */
+#include "fuse.h"
+
+static const char *const names[FUSE_COUNT] = {
+    [FUSE_NUM_OP] = "N op",
+    [FUSE_DUP_DUMP] = "dup dump",
+    [FUSE_DUP_NUM_OP] = "dup N op",
+};
+
+/* Name of pattern `pat`. */
+const char *fuse_name(int pat)
+{
+    return pat >= 0 && pat < FUSE_COUNT ? names[pat] : "???";
+}
+
+/* Print `st` to `to`, prefixed with `who`. */
+void fuse_stats(const fusestats_t *st, const char *who, FILE *to)
+{
+    fprintf(to, "%s: fused", who);
+    for(int i = 0; i < FUSE_COUNT; i++) {
+        fprintf(to, "%s %zu `%s`", i ? "," : "", st->fused[i], names[i]);
+    }
+    fputc('\n', to);
+}
@@ -0,0 +1,44 @@
+/*
+ * Copyright (C) 2025 therealblue24.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Header file for superinstruction fusion.
+ *
+ * A few short token sequences make up most stac code. Those get fused
+ * into one op, with any number in them as an immediate operand: the IR
+ * builder fuses `N op` into a binop with an immediate, and the VM
+ * compiler all of them into their own ops.
+ *
+ * The sequences are the most frequent n-grams of a corpus of stac
+ * programs, see bench/fuse.c for the census.
+ */
+#ifndef FUSE_H_
+#define FUSE_H_
+
+#include "util.h"
+
+/* Fused sequences, most frequent first. */
+enum fusepat {
+    FUSE_NUM_OP, /* `N +`, `N -`, `N *`, `N /`, and `N <` and the
+                  * other comparisons in the IR */
+    FUSE_DUP_DUMP, /* `dup dump` */
+    FUSE_DUP_NUM_OP, /* `dup N +`, `dup N -`, `dup N *` */
+
+    FUSE_COUNT,
+};
+
+/* How many of each sequence were fused. */
+typedef struct fusestats {
+    size_t fused[FUSE_COUNT];
+} fusestats_t;
+
+/* Name of pattern `pat`. */
+const char *fuse_name(int pat);
+
+/* Print `st` to `to`, prefixed with `who`. */
+void fuse_stats(const fusestats_t *st, const char *who, FILE *to);
+
+#endif /* FUSE_H_ */
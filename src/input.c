@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2025 therealblue24.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Reading source input: mmap for files, a read loop for everything else.
+ */
+#include "input.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* what empty inputs point at */
+static const uint8_t empty[1] = { 0 };
+
+/* Read all of `fd` into a growing heap buffer. */
+static int input_slurp(input_t *in, int fd)
+{
+    LIST(uint8_t) buf = { 0 };
+    for(;;) {
+        /* always leave room for a big read */
+        list_resize(&buf, buf.size + 65536);
+        ssize_t n = read(fd, buf.elems + buf.size, buf.cap - buf.size);
+        if(n < 0) {
+            if(errno == EINTR) {
+                continue;
+            }
+            free(buf.elems);
+            return 1;
+        }
+        if(n == 0) {
+            break;
+        }
+        buf.size += (size_t)n;
+    }
+    in->buf = buf.elems;
+    in->len = buf.size;
+    in->mapped = false;
+    return 0;
+}
+
+/* Open `path` into `in`. "-" reads stdin.
+ * Regular files are mapped read-only, everything else (pipes,
+ * terminals, ...) is read into a growing buffer.
+ * Returns nonzero on failure, with errno set. */
+int input_open(input_t *in, const char *path)
+{
+    bool is_stdin = strcmp(path, "-") == 0;
+    int fd = is_stdin ? STDIN_FILENO : open(path, O_RDONLY);
+    if(fd < 0) {
+        return 1;
+    }
+
+    in->name = is_stdin ? "<stdin>" : path;
+    in->buf = empty;
+    in->len = 0;
+    in->mapped = false;
+
+    struct stat st;
+    int rc = 0;
+    if(fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+        if(st.st_size > 0) {
+            void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE,
+                             fd, 0);
+            if(map != MAP_FAILED) {
+                /* the lexer goes front to back, exactly once */
+                (void)madvise(map, (size_t)st.st_size, MADV_SEQUENTIAL);
+                in->buf = map;
+                in->len = (size_t)st.st_size;
+                in->mapped = true;
+            } else {
+                rc = input_slurp(in, fd);
+            }
+        }
+    } else {
+        rc = input_slurp(in, fd);
+    }
+
+    if(!is_stdin) {
+        int e = errno;
+        close(fd);
+        errno = e;
+    }
+    return rc;
+}
+
+/* Release the contents of `in`. */
+void input_close(input_t *in)
+{
+    if(in->mapped) {
+        munmap((void *)in->buf, in->len);
+    } else if(in->buf != empty) {
+        free((void *)in->buf);
+    }
+    in->buf = NULL;
+    in->len = 0;
+    in->mapped = false;
+}
@@ -0,0 +1,32 @@
+/*
+ * Copyright (C) 2025 therealblue24.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Header file for reading source input.
+ */
+#ifndef INPUT_H_
+#define INPUT_H_
+
+#include "util.h"
+
+/* Source input. `buf` stays valid until `input_close`. */
+typedef struct input {
+    const uint8_t *buf; /* contents, never NULL once opened */
+    size_t len; /* size of `buf` */
+    const char *name; /* name for diagnostics */
+    bool mapped; /* `buf` is a read-only mapping, else heap memory */
+} input_t;
+
+/* Open `path` into `in`. "-" reads stdin.
+ * Regular files are mapped read-only, everything else (pipes,
+ * terminals, ...) is read into a growing buffer.
+ * Returns nonzero on failure, with errno set. */
+int input_open(input_t *in, const char *path);
+
+/* Release the contents of `in`. */
+void input_close(input_t *in);
+
+#endif /* INPUT_H_ */
@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2025 therealblue24.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * String interning.
+ */
+#include "intern.h"
+
+/* Set up an empty table. */
+void intern_init(intern_t *in)
+{
+    arena_init(&in->arena);
+    in->strs.elems = NULL;
+    in->strs.size = in->strs.cap = 0;
+    in->slots = NULL;
+    in->nslots = 0;
+    in->lookups = in->bytes_saved = 0;
+}
+
+/* 8 bytes at a time, literals can be long */
+static uint64_t intern_hash(const uint8_t *s, size_t n)
+{
+    uint64_t h = 0x9e3779b97f4a7c15ull ^ n;
+    uint64_t w;
+    while(n >= 8) {
+        memcpy(&w, s, 8);
+        h = (h ^ w) * 0xbf58476d1ce4e5b9ull;
+        h ^= h >> 31;
+        s += 8;
+        n -= 8;
+    }
+    w = 0;
+    memcpy(&w, s, n);
+    h = (h ^ w) * 0x94d049bb133111ebull;
+    return h ^ (h >> 29);
+}
+
+/* Double the slot array and reinsert everything. */
+static void intern_grow(intern_t *in)
+{
+    size_t n = size_max(64, in->nslots * 2);
+    uint32_t *slots = zcalloc(n, sizeof(*slots));
+    for(size_t id = 0; id < in->strs.size; id++) {
+        size_t i = in->strs.elems[id].hash & (n - 1);
+        while(slots[i]) {
+            i = (i + 1) & (n - 1);
+        }
+        slots[i] = (uint32_t)id + 1;
+    }
+    free(in->slots);
+    in->slots = slots;
+    in->nslots = n;
+}
+
+/* Slot of `size` bytes at `s` with hash `h`: the one with its ID, or
+ * the empty one it would go in. */
+static size_t intern_slot(const intern_t *in, const uint8_t *s, size_t size,
+                          uint64_t h)
+{
+    size_t i = h & (in->nslots - 1);
+    while(in->slots[i]) {
+        istr_t str = in->strs.elems[in->slots[i] - 1];
+        if(str.hash == h && str.size == size &&
+           memcmp(str.str, s, size) == 0) {
+            break;
+        }
+        i = (i + 1) & (in->nslots - 1);
+    }
+    return i;
+}
+
+/* Intern `size` bytes at `s`. Returns the ID of the string. */
+uint32_t intern_put(intern_t *in, const uint8_t *s, size_t size)
+{
+    in->lookups++;
+
+    /* keep the load factor under 1/2 */
+    if((in->strs.size + 1) * 2 > in->nslots) {
+        intern_grow(in);
+    }
+
+    uint64_t h = intern_hash(s, size);
+    size_t i = intern_slot(in, s, size, h);
+    if(in->slots[i]) {
+        in->bytes_saved += size + 1;
+        return in->slots[i] - 1;
+    }
+
+    /* new one, copy it into the arena */
+    uint8_t *copy = arena_alloc_aligned(&in->arena, size + 1, 1);
+    memcpy(copy, s, size);
+    copy[size] = 0;
+
+    uint32_t id = (uint32_t)in->strs.size;
+    istr_t str = { copy, size, h };
+    list_append(&in->strs, str);
+    in->slots[i] = id + 1;
+    return id;
+}
+
+/* ID of the `size` bytes at `s`, or INTERN_NONE if they were never
+ * interned. */
+uint32_t intern_find(const intern_t *in, const uint8_t *s, size_t size)
+{
+    if(in->nslots == 0) {
+        return INTERN_NONE;
+    }
+    size_t i = intern_slot(in, s, size, intern_hash(s, size));
+    return in->slots[i] ? in->slots[i] - 1 : INTERN_NONE;
+}
+
+/* Print stats about `in` to `to`. */
+void intern_stats(const intern_t *in, FILE *to)
+{
+    /* every literal used to get a malloc() of its own */
+    size_t allocs_saved = in->lookups - in->arena.nchunks;
+    if(in->arena.nchunks > in->lookups) {
+        allocs_saved = 0;
+    }
+    fprintf(to, "strings: %zu literals, %zu unique, %zu bytes stored\n",
+            in->lookups, in->strs.size, in->arena.bytes);
+    fprintf(to, "strings: saved %zu bytes and %zu allocations\n",
+            in->bytes_saved, allocs_saved);
+}
+
+/* Free the table and all its strings in one go. */
+void intern_free(intern_t *in)
+{
+    arena_free(&in->arena);
+    free(in->strs.elems);
+    free(in->slots);
+    intern_init(in);
+}
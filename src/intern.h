@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2025 therealblue24.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Header file for string interning.
+ */
+#ifndef INTERN_H_
+#define INTERN_H_
+
+#include "util.h"
+#include "arena.h"
+
+/* An interned string. */
+typedef struct istr {
+    const uint8_t *str; /* NUL-terminated, lives in the table's arena */
+    size_t size; /* without the NUL */
+    uint64_t hash;
+} istr_t;
+
+/* String intern table. Equal strings get the same ID and share one
+ * copy, which lives until `intern_free`. IDs count up from 0. */
+typedef struct intern {
+    arena_t arena; /* string storage */
+    LIST(istr_t) strs; /* by ID */
+    uint32_t *slots; /* open addressing, ID + 1, 0 = empty */
+    size_t nslots; /* power of two */
+
+    /* -- stats -- */
+    size_t lookups; /* `intern_put` calls */
+    size_t bytes_saved; /* bytes duplicates didn't need */
+} intern_t;
+
+/* Set up an empty table. */
+void intern_init(intern_t *in);
+
+/* Intern `size` bytes at `s`. Returns the ID of the string. */
+uint32_t intern_put(intern_t *in, const uint8_t *s, size_t size);
+
+/* no such string, see `intern_find` */
+#define INTERN_NONE UINT32_MAX
+
+/* ID of the `size` bytes at `s`, or INTERN_NONE if they were never
+ * interned. */
+uint32_t intern_find(const intern_t *in, const uint8_t *s, size_t size);
+
+/* The string with ID `id`. */
+static inline istr_t intern_get(const intern_t *in, uint32_t id)
+{
+    return in->strs.elems[id];
+}
+
+/* Print stats about `in` to `to`. */
+void intern_stats(const intern_t *in, FILE *to);
+
+/* Free the table and all its strings in one go. */
+void intern_free(intern_t *in);
+
+#endif /* INTERN_H_ */
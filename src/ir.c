@@ -0,0 +1,906 @@
+/*
+ * Copyright (C) 2025 therealblue24.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Stack-machine IR: building it from tokens, and dumping it.
+ */
+#include "ir.h"
+#include "depth.h"
+#include "width.h"
+#include <inttypes.h>
+
+static const char *const opnames[IR_COUNT] = {
+    [IR_NOP] = "nop",         [IR_ICONST] = "iconst", [IR_UCONST] = "uconst",
+    [IR_ADD] = "add",         [IR_SUB] = "sub",       [IR_MUL] = "mul",
+    [IR_DIV] = "div",         [IR_EQ] = "eq",         [IR_NE] = "ne",
+    [IR_LT] = "lt",           [IR_LE] = "le",         [IR_GT] = "gt",
+    [IR_GE] = "ge",           [IR_DUP] = "dup",       [IR_DROP] = "drop",
+    [IR_DROPALL] = "dropall", [IR_SWAP] = "swap",     [IR_OVER] = "over",
+    [IR_DUMP] = "dump",       [IR_CALL] = "call",     [IR_RET] = "ret",
+    [IR_LABEL] = "label",     [IR_JMP] = "jmp",       [IR_JNZ] = "jnz",
+    [IR_PHI] = "phi",         [IR_FUNC] = "func",     [IR_PARAM] = "param",
+    [IR_ARG] = "arg",         [IR_CALLF] = "callf",   [IR_EXT] = "ext",
+    [IR_TAIL] = "tail",
+};
+
+/* binop of each operator token */
+static const uint8_t binops[TOK__COUNTR] = {
+    [TOK_ADD] = IR_ADD, [TOK_SUB] = IR_SUB, [TOK_MUL] = IR_MUL,
+    [TOK_DIV] = IR_DIV, [TOK_EQ] = IR_EQ,   [TOK_NE] = IR_NE,
+    [TOK_LT] = IR_LT,   [TOK_LE] = IR_LE,   [TOK_GT] = IR_GT,
+    [TOK_GE] = IR_GE,
+};
+
+/* IRT_* of each type keyword */
+static const uint8_t irtys[TOK__COUNTR] = {
+    [TOK_CHAR] = IRT_B,       [TOK_UCHAR] = IRT_UB,
+    [TOK_SHORT] = IRT_H,      [TOK_USHORT] = IRT_UH,
+    [TOK_INT] = IRT_W,        [TOK_UINT] = IRT_UW,
+    [TOK_LONG] = IRT_L,       [TOK_ULONG] = IRT_UL,
+    [TOK_STR] = IRT_L,        [TOK_PTR] = IRT_L,
+    [TOK_NONE] = IRT_NONE,    [TOK_SIZE_T] = IRT_UL,
+    [TOK_INTMAX_T] = IRT_L,   [TOK_UINTMAX_T] = IRT_UL,
+    [TOK_INT8_T] = IRT_B,     [TOK_UINT8_T] = IRT_UB,
+    [TOK_INT16_T] = IRT_H,    [TOK_UINT16_T] = IRT_UH,
+    [TOK_INT32_T] = IRT_W,    [TOK_UINT32_T] = IRT_UW,
+    [TOK_INT64_T] = IRT_L,    [TOK_UINT64_T] = IRT_UL,
+};
+
+/* Name of op `op`. */
+const char *ir_opname(int op)
+{
+    return op >= 0 && op < IR_COUNT ? opnames[op] : "???";
+}
+
+/* The stack a jump (or falling through) takes into a block. */
+struct edge {
+    uint32_t *stack; /* value in every slot, NULL if it's never taken */
+    int32_t depth;
+    uint32_t from; /* block it leaves */
+};
+
+/* `if` or `while` that hasn't seen its `end` yet. */
+struct ctl {
+    int kind; /* TOK_IF, TOK_THEN, TOK_ELSE, TOK_WHILE or TOK_DO, the
+               * last of its keywords so far */
+    uint32_t tok; /* the `if` or `while` */
+    int32_t depth; /* loops: depth going in */
+    uint32_t head; /* loops: index of the label on top */
+    uint32_t next; /* block after THEN or DO if the branch isn't taken,
+                    * block after `end` for ELSE */
+    struct edge skip; /* THEN, DO: edge to `next`; ELSE: from `then` */
+};
+
+/* Builder state. */
+struct irb {
+    ir_t *ir;
+    lex_t *lex;
+    uint32_t *stack; /* value (vreg) in every stack slot */
+    int32_t depth;
+    uint32_t blk; /* block the ops go into */
+    bool dead; /* after `ret`, until a label that's jumped to */
+    struct ctl *ctl;
+    size_t nctl;
+    uint32_t fn; /* function being built */
+};
+
+/* Make room for another op. The builder mostly makes one op per
+ * token, phis are what can go over that. */
+static void ir_grow(ir_t *ir)
+{
+    if(ir->size < ir->cap) {
+        return;
+    }
+    irins_t *ins = arena_alloc(&ir->arena, ir->cap * 2 * sizeof(*ins));
+    memcpy(ins, ir->ins, ir->size * sizeof(*ins));
+    ir->ins = ins;
+    ir->cap *= 2;
+}
+
+/* New op `op` from token `tok`, with nothing filled in. */
+static irins_t *ir_new(struct irb *b, int op, uint32_t tok)
+{
+    ir_grow(b->ir);
+    irins_t *in = &b->ir->ins[b->ir->size++];
+    memset(in, 0, sizeof(*in));
+    in->op = (uint8_t)op;
+    in->depth = b->depth;
+    in->dst = in->a = in->b = IR_NOREG;
+    in->tok = tok;
+    return in;
+}
+
+/* The edge from here, where the stack is as it is now. */
+static struct edge ir_edge(struct irb *b)
+{
+    struct edge e = { .depth = b->depth, .from = b->blk };
+    if(!b->dead) {
+        size_t size = size_max((size_t)b->depth, 1) * sizeof(*e.stack);
+        e.stack = arena_alloc(&b->ir->arena, size);
+        memcpy(e.stack, b->stack, (size_t)b->depth * sizeof(*e.stack));
+    }
+    return e;
+}
+
+/* Jump to block `to`, unless this is dead code. */
+static void ir_jmp(struct irb *b, uint32_t tok, uint32_t to)
+{
+    if(!b->dead) {
+        ir_new(b, IR_JMP, tok)->imm.blk[0] = to;
+    }
+    b->dead = true;
+}
+
+/* Branch on the top of the stack, to `yes` if it isn't 0 and to `no`
+ * if it is, which `skip` is the edge to. */
+static void ir_jnz(struct irb *b, uint32_t tok, uint32_t yes, uint32_t no,
+                   struct edge *skip)
+{
+    uint32_t cond = b->stack[--b->depth];
+    if(!b->dead) {
+        irins_t *in = ir_new(b, IR_JNZ, tok);
+        in->a = cond;
+        in->imm.blk[0] = yes;
+        in->imm.blk[1] = no;
+    }
+    *skip = ir_edge(b);
+    b->dead = true;
+}
+
+/* Start block `id`, which edges `e1` and `e2` go into (either may
+ * never be taken), and they have to agree on the depth. A phi picks
+ * up every stack slot. */
+static void ir_label(struct irb *b, uint32_t id, uint32_t tok,
+                     const struct edge *e1, const struct edge *e2)
+{
+    const struct edge *in[2];
+    int n = 0;
+    if(e1->stack) {
+        in[n++] = e1;
+    }
+    if(e2 && e2->stack) {
+        in[n++] = e2;
+    }
+    if(n > 0) {
+        b->depth = in[0]->depth;
+    }
+    ir_new(b, IR_LABEL, tok)->imm.blk[0] = id;
+    for(int32_t k = 0; n > 0 && k < b->depth; k++) {
+        irins_t *phi = ir_new(b, IR_PHI, tok);
+        phi->dst = b->stack[k] = b->ir->nvregs++;
+        phi->a = in[0]->stack[k];
+        phi->imm.blk[0] = in[0]->from;
+        if(n > 1) {
+            phi->b = in[1]->stack[k];
+            phi->imm.blk[1] = in[1]->from;
+        }
+    }
+    b->blk = id;
+    b->dead = n == 0;
+}
+
+/* Control flow keyword `it`, token number `tok`, which `depth_check`
+ * has seen in its place. */
+static void ir_control(struct irb *b, const token_t *it, uint32_t tok)
+{
+    ir_t *ir = b->ir;
+    struct ctl *c = b->nctl > 0 ? &b->ctl[b->nctl - 1] : NULL;
+    int kind = c ? c->kind : -1;
+
+    switch(it->toktype) {
+    case TOK_IF:
+    case TOK_WHILE:
+        c = &b->ctl[b->nctl++];
+        memset(c, 0, sizeof(*c));
+        c->kind = (int)it->toktype;
+        c->tok = tok;
+        c->depth = b->depth;
+        if(it->toktype == TOK_WHILE) {
+            /* the phis get the way back in at `end` */
+            uint32_t head = ir->nblocks++;
+            struct edge in = ir_edge(b);
+            ir_jmp(b, tok, head);
+            c->head = (uint32_t)ir->size;
+            ir_label(b, head, tok, &in, NULL);
+        }
+        return;
+    case TOK_THEN:
+    case TOK_DO: {
+        uint32_t yes = ir->nblocks++;
+        c->kind = (int)it->toktype;
+        c->next = ir->nblocks++;
+        ir_jnz(b, tok, yes, c->next, &c->skip);
+        ir_label(b, yes, tok, &c->skip, NULL);
+        return;
+    }
+    case TOK_ELSE: {
+        struct edge then = ir_edge(b);
+        uint32_t join = ir->nblocks++;
+        ir_jmp(b, tok, join);
+        ir_label(b, c->next, tok, &c->skip, NULL);
+        c->kind = TOK_ELSE;
+        c->next = join;
+        c->skip = then;
+        return;
+    }
+    case TOK_END: {
+        struct edge fall = ir_edge(b);
+        b->nctl--;
+        if(kind == TOK_DO) {
+            /* only a loop that's entered can come back around */
+            irins_t *head = &ir->ins[c->head];
+            for(int32_t k = 0; fall.stack && k < fall.depth; k++) {
+                head[1 + k].b = fall.stack[k];
+                head[1 + k].imm.blk[1] = fall.from;
+            }
+            ir_jmp(b, tok, head->imm.blk[0]);
+            ir_label(b, c->next, tok, &c->skip, NULL);
+            return;
+        }
+        ir_jmp(b, tok, c->next);
+        ir_label(b, c->next, tok, &c->skip, &fall);
+        return;
+    }
+    default:
+        return;
+    }
+}
+
+/* Whether token type `t` is a type keyword. */
+static bool ir_is_type(int t)
+{
+    return t >= TOK_CHAR && t <= TOK_INT64_T;
+}
+
+/* Read the header of the function whose `func` is `fn` up to its `do`,
+ * and find its `end`, into the next of `ir->funcs`. `scratch` holds the
+ * parameters until it's known how many there are.
+ * Returns nonzero on failure. */
+static int ir_header(ir_t *ir, lex_t *lex, tokiter_t *iter,
+                     const token_t *fn, uint8_t *scratch)
+{
+    irfunc_t *f = &ir->funcs[ir->nfuncs];
+    memset(f, 0, sizeof(*f));
+    f->leaf = true;
+    token_t it;
+    if(!lex_iter(lex, iter, &it) || it.toktype != TOK_SPECIAL_LIT) {
+        LEX_ERR(lex, (size_t)(fn->raw - lex->buf), fn->range,
+                "`func` needs a name");
+        return 1;
+    }
+    f->off = (uint32_t)(it.raw - lex->buf);
+    f->len = (uint32_t)it.range;
+    /* a name that's new gets the next ID */
+    if(intern_put(&ir->names, it.raw, it.range) + 1 != ir->nfuncs) {
+        LEX_ERR(lex, (size_t)(it.raw - lex->buf), it.range,
+                "`%.*s` is already defined", (int)it.range, it.raw);
+        return 1;
+    }
+
+    /* parameters up to `->`, then what it returns up to `do`, if it
+     * returns anything */
+    bool rets = false;
+    uint32_t nrets = 0;
+    while(lex_iter(lex, iter, &it)) {
+        if(it.toktype == TOK_ARROW && !rets) {
+            rets = true;
+            continue;
+        }
+        if(it.toktype == TOK_DO) {
+            break;
+        }
+        if(!ir_is_type(it.toktype)) {
+            LEX_ERR(lex, (size_t)(it.raw - lex->buf), it.range,
+                    rets ? "expected a type or `do`"
+                         : "expected a type, `->` or `do`");
+            return 1;
+        }
+        if(it.toktype == TOK_NONE) {
+            continue;
+        }
+        if(!rets) {
+            scratch[f->nparams++] = irtys[it.toktype];
+        } else if(nrets++ > 0) {
+            LEX_ERR(lex, (size_t)(it.raw - lex->buf), it.range,
+                    "functions return one value at most");
+            return 1;
+        } else {
+            f->ret = irtys[it.toktype];
+        }
+    }
+    if(it.toktype != TOK_DO) {
+        LEX_ERR(lex, (size_t)(fn->raw - lex->buf), fn->range,
+                "`func` without `do`");
+        return 1;
+    }
+    f->params = arena_alloc(&ir->arena, size_max(f->nparams, 1));
+    memcpy(f->params, scratch, f->nparams);
+
+    /* the body ends at the `end` that isn't an `if`'s or a `while`'s */
+    f->body = (uint32_t)iter->i;
+    int open = 1;
+    while(lex_iter(lex, iter, &it)) {
+        if(it.toktype == TOK_FUNC) {
+            LEX_ERR(lex, (size_t)(it.raw - lex->buf), it.range,
+                    "`func` inside a function");
+            return 1;
+        }
+        open += it.toktype == TOK_IF || it.toktype == TOK_WHILE;
+        if(it.toktype == TOK_END && --open == 0) {
+            f->end = (uint32_t)(iter->i - 1);
+            ir->nfuncs++;
+            return 0;
+        }
+    }
+    LEX_ERR(lex, (size_t)(fn->raw - lex->buf), fn->range,
+            "`func` without `end`");
+    return 1;
+}
+
+/* Find every function, after `main` which is the top level.
+ * Returns nonzero on failure. */
+static int ir_funcs(ir_t *ir, lex_t *lex)
+{
+    const tokstore_t *ts = &lex->toks;
+    size_t n = 1;
+    for(size_t i = 0; i < ts->size; i++) {
+        n += ts->type[i] == TOK_FUNC;
+    }
+    ir->funcs = arena_alloc(&ir->arena, n * sizeof(*ir->funcs));
+    memset(ir->funcs, 0, sizeof(*ir->funcs));
+    ir->funcs[0].ret = IRT_L;
+    ir->funcs[0].end = (uint32_t)ts->size;
+    ir->nfuncs = 1;
+    if(n == 1) {
+        return 0;
+    }
+
+    uint8_t *scratch = arena_alloc(&ir->arena, ts->size);
+    int open = 0; /* `if`s and `while`s */
+    tokiter_t iter = { 0 };
+    token_t it;
+    while(lex_iter(lex, &iter, &it)) {
+        if(it.toktype == TOK_IF || it.toktype == TOK_WHILE) {
+            open++;
+        } else if(it.toktype == TOK_END) {
+            open -= open > 0;
+        } else if(it.toktype == TOK_FUNC) {
+            if(open > 0) {
+                LEX_ERR(lex, (size_t)(it.raw - lex->buf), it.range,
+                        "`func` inside `if` or `while`");
+                return 1;
+            }
+            if(ir_header(ir, lex, &iter, &it, scratch)) {
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+/* Call function `f` at token number `tok`, with its arguments on top
+ * of the stack. */
+static void ir_call(struct irb *b, const irfunc_t *f, uint32_t tok)
+{
+    ir_t *ir = b->ir;
+    int32_t n = (int32_t)f->nparams;
+    for(int32_t k = 0; k < n; k++) {
+        ir_new(b, IR_ARG, tok)->a = b->stack[b->depth - n + k];
+    }
+    b->depth -= n;
+    irins_t *in = ir_new(b, IR_CALLF, tok);
+    in->imm.func.fn = (uint32_t)(f - ir->funcs);
+    if(f->ret != IRT_NONE) {
+        in->dst = b->stack[b->depth++] = ir->nvregs++;
+    }
+    ir->funcs[b->fn].leaf = false;
+}
+
+/* Build the ops of function `fn`, whose stack effects `depth_check`
+ * has checked, reporting ops it can't build through `b->lex`.
+ * Returns nonzero on failure. */
+static int ir_func(struct irb *b, uint32_t fn)
+{
+    ir_t *ir = b->ir;
+    lex_t *lex = b->lex;
+    irfunc_t *f = &ir->funcs[fn];
+    b->fn = fn;
+    b->depth = 0;
+    b->dead = false;
+    b->nctl = 0;
+    f->start = (uint32_t)ir->size;
+    if(fn > 0) {
+        /* the parameters are on the stack coming in, the first one at
+         * the bottom */
+        b->blk = ir->nblocks++;
+        irins_t *in = ir_new(b, IR_FUNC, f->body - 1);
+        in->imm.func.blk = b->blk;
+        in->imm.func.fn = fn;
+        for(uint32_t k = 0; k < f->nparams; k++) {
+            in = ir_new(b, IR_PARAM, f->body - 1);
+            in->dst = b->stack[b->depth++] = ir->nvregs++;
+            in->imm.i = k;
+        }
+    }
+
+    uint32_t nextfn = 1; /* next function `main` skips */
+    tokiter_t iter;
+    lex_iter_at(lex, &iter, f->body);
+    token_t it;
+    while(iter.i < f->end && lex_iter(lex, &iter, &it)) {
+        ir_grow(ir);
+        irins_t *in = &ir->ins[ir->size];
+        in->depth = b->depth;
+        in->dst = in->a = in->b = IR_NOREG;
+        in->tok = (uint32_t)(iter.i - 1);
+
+        uint32_t *sp = b->stack + b->depth; /* sp[-1] is the top */
+        switch(it.toktype) {
+        case TOK_ADD:
+        case TOK_SUB:
+        case TOK_MUL:
+        case TOK_DIV:
+        case TOK_EQ:
+        case TOK_NE:
+        case TOK_LT:
+        case TOK_LE:
+        case TOK_GT:
+        case TOK_GE:
+            in->op = binops[it.toktype];
+            /* `N op`: the constant becomes the immediate `a` */
+            if(ir->size > f->start && in[-1].dst == sp[-1] &&
+               (in[-1].op == IR_ICONST || in[-1].op == IR_UCONST)) {
+                in[-1].op = in->op;
+                in[-1].tok = in->tok;
+                in[-1].b = sp[-2];
+                sp[-2] = in[-1].dst;
+                ir->fused.fused[FUSE_NUM_OP]++;
+                b->depth--;
+                /* no new op */
+                continue;
+            }
+            /* top of stack first: `a b -` is `b - a` */
+            in->a = sp[-1];
+            in->b = sp[-2];
+            in->dst = sp[-2] = ir->nvregs++;
+            b->depth--;
+            break;
+        case TOK_DUMP:
+            in->op = IR_DUMP;
+            in->a = sp[-1];
+            b->depth--;
+            break;
+        case TOK_DUP:
+            /* same value twice, nothing to copy */
+            in->op = IR_DUP;
+            in->a = sp[0] = sp[-1];
+            b->depth++;
+            break;
+        case TOK_DROP:
+            in->op = IR_DROP;
+            in->a = sp[-1];
+            b->depth--;
+            break;
+        case TOK_DROPALL:
+            in->op = IR_DROPALL;
+            b->depth = 0;
+            break;
+        case TOK_SWAP:
+            in->op = IR_SWAP;
+            in->a = sp[-1];
+            in->b = sp[-2];
+            sp[-1] = in->b;
+            sp[-2] = in->a;
+            break;
+        case TOK_OVER:
+            in->op = IR_OVER;
+            in->a = sp[-1];
+            in->b = sp[0] = sp[-2];
+            b->depth++;
+            break;
+        case TOK_RET:
+            /* functions that return nothing just leave */
+            if(f->ret != IRT_NONE) {
+                in->a = sp[-1];
+            }
+            in->op = IR_RET;
+            b->depth = 0;
+            break;
+        case TOK_NUM_INT:
+            in->op = IR_ICONST;
+            in->dst = sp[0] = ir->nvregs++;
+            in->imm.i = it.tok_num.signd;
+            b->depth++;
+            break;
+        case TOK_NUM_INTU:
+            in->op = IR_UCONST;
+            in->dst = sp[0] = ir->nvregs++;
+            in->imm.u = it.tok_num.unsignd;
+            b->depth++;
+            break;
+        case TOK_SPECIAL_LIT: {
+            const irfunc_t *callee =
+                ir_lookup(ir->funcs, &ir->names, it.raw, it.range);
+            if(callee) {
+                ir_call(b, callee, in->tok);
+                continue;
+            }
+            in->op = IR_CALL;
+            in->dst = sp[0] = ir->nvregs++;
+            in->imm.sym.off = (uint32_t)(it.raw - lex->buf);
+            in->imm.sym.len = (uint32_t)it.range;
+            b->depth++;
+            break;
+        }
+        case TOK_FUNC:
+            /* only `main` runs into these, and they're built on their
+             * own */
+            lex_iter_at(lex, &iter, ir->funcs[nextfn++].end + 1);
+            continue;
+        case TOK_IF:
+        case TOK_THEN:
+        case TOK_ELSE:
+        case TOK_WHILE:
+        case TOK_DO:
+        case TOK_END:
+            ir_control(b, &it, in->tok);
+            continue;
+        default:
+            LEX_ERR(lex, (size_t)(it.raw - lex->buf), it.range,
+                    "unsupported op");
+            return 1;
+        }
+        ir->size++;
+        /* nothing after `ret` runs until something jumps there */
+        b->dead = b->dead || in->op == IR_RET;
+    }
+    /* running into the `end` of a function returns */
+    if(fn > 0 && !b->dead) {
+        irins_t *in = ir_new(b, IR_RET, f->end);
+        if(f->ret != IRT_NONE) {
+            in->a = b->stack[b->depth - 1];
+        }
+    }
+    return 0;
+}
+
+/* Whether the value `v` that op `i` of block `blk` leaves gets returned
+ * right away, by way of nothing but stack shuffles and jumps. With
+ * `any`, it's enough to return at all. */
+static bool ir_returned(const ir_t *ir, size_t i, uint32_t blk, uint32_t v,
+                        bool any)
+{
+    /* every block at most once, jumps can't go around in circles */
+    for(uint32_t hops = 0; hops <= ir->nblocks; hops++) {
+        for(i++; i < ir->size && !ir_has_code(ir->ins[i].op); i++) {
+        }
+        if(i >= ir->size) {
+            return false;
+        }
+        const irins_t *in = &ir->ins[i];
+        if(in->op == IR_RET) {
+            return any || in->a == v;
+        }
+        if(in->op != IR_JMP) {
+            return false;
+        }
+        /* follow `v` into the phi it goes to, the top one if it's in
+         * more than one */
+        uint32_t to = in->imm.blk[0], w = IR_NOREG;
+        for(i = ir->blocks[to] + 1; i < ir->size && ir->ins[i].op == IR_PHI;
+            i++) {
+            const irins_t *phi = &ir->ins[i];
+            if((phi->imm.blk[0] == blk && phi->a == v) ||
+               (phi->b != IR_NOREG && phi->imm.blk[1] == blk && phi->b == v)) {
+                w = phi->dst;
+            }
+        }
+        i--;
+        if(w == IR_NOREG && !any) {
+            return false;
+        }
+        v = w;
+        blk = to;
+    }
+    return false;
+}
+
+/* Turn calls whose result is returned right away into IR_TAILs. Their
+ * `ret`, or the jump on the way to it, goes, and `ir_prune` takes the
+ * call's block out of the phis it went to. Only a call to the same
+ * function, or one that returns the same type, can be a tail call: the
+ * caller extends what comes back by that. */
+static void ir_tails(ir_t *ir)
+{
+    uint32_t fn = 0, blk = 0;
+    for(size_t i = 0; i < ir->size; i++) {
+        irins_t *in = &ir->ins[i];
+        if(in->op == IR_FUNC) {
+            fn = in->imm.func.fn;
+            blk = in->imm.func.blk;
+        } else if(in->op == IR_LABEL) {
+            blk = in->imm.blk[0];
+        }
+        if(in->op != IR_CALLF || fn == 0) {
+            continue;
+        }
+        const irfunc_t *f = &ir->funcs[fn];
+        const irfunc_t *g = &ir->funcs[in->imm.func.fn];
+        bool any = f->ret == IRT_NONE;
+        if((g != f && g->ret != f->ret && !any) ||
+           !ir_returned(ir, i, blk, in->dst, any)) {
+            continue;
+        }
+        in->op = IR_TAIL;
+        in->dst = IR_NOREG;
+        size_t j = i + 1;
+        while(!ir_has_code(ir->ins[j].op)) {
+            j++;
+        }
+        ir->ins[j].op = IR_NOP;
+    }
+}
+
+/* Build `ir` from the tokens of `lex`, reporting errors through it.
+ * Returns nonzero on failure. */
+int ir_build(ir_t *ir, lex_t *lex)
+{
+    memset(ir, 0, sizeof(*ir));
+    arena_init(&ir->arena);
+    ir->src = lex->buf;
+    /* about one op per token, and `if`s and `while`s can't nest any
+     * deeper than that */
+    size_t ntoks = size_max(lex->toks.size, 1);
+    ir->cap = ntoks;
+    ir->ins = arena_alloc(&ir->arena, ir->cap * sizeof(*ir->ins));
+    ir->nblocks = 1;
+    intern_init(&ir->names);
+    if(ir_funcs(ir, lex) ||
+       depth_check(lex, ir->funcs, ir->nfuncs, &ir->names)) {
+        return 1;
+    }
+    for(uint32_t fn = 0; fn < ir->nfuncs; fn++) {
+        if(ir->funcs[fn].maxdepth > ir->maxdepth) {
+            ir->maxdepth = ir->funcs[fn].maxdepth;
+        }
+    }
+    struct irb b = { .ir = ir, .lex = lex };
+    b.stack = arena_alloc(&ir->arena, (ir->maxdepth + 1) * sizeof(*b.stack));
+    b.ctl = arena_alloc(&ir->arena, ntoks * sizeof(*b.ctl));
+
+    for(uint32_t fn = 0; fn < ir->nfuncs; fn++) {
+        if(ir_func(&b, fn)) {
+            return 1;
+        }
+    }
+    ir_index_blocks(ir);
+    ir_tails(ir);
+    ir_prune(ir);
+    width_signs(ir);
+    return 0;
+}
+
+/* Work out `ir->blocks` and where functions start again, after ops
+ * moved around. */
+void ir_index_blocks(ir_t *ir)
+{
+    ir->blocks = arena_alloc(&ir->arena, ir->nblocks * sizeof(*ir->blocks));
+    ir->blocks[0] = 0;
+    for(uint32_t fn = 1; fn < ir->nfuncs; fn++) {
+        ir->funcs[fn].start = IR_NOREG;
+    }
+    for(size_t i = 0; i < ir->size; i++) {
+        const irins_t *in = &ir->ins[i];
+        if(in->op == IR_LABEL) {
+            ir->blocks[in->imm.blk[0]] = (uint32_t)i;
+        } else if(in->op == IR_FUNC) {
+            ir->blocks[in->imm.func.blk] = (uint32_t)i;
+            ir->funcs[in->imm.func.fn].start = (uint32_t)i;
+        }
+    }
+}
+
+/* Count block `blk` in, if it isn't already, and put it on `work`.
+ * `end` is what `ir_prune` works out. */
+static void ir_reach(const ir_t *ir, uint32_t *end, uint32_t *work,
+                     size_t *nwork, uint32_t blk)
+{
+    if(end[blk] == IR_NOREG) {
+        end[blk] = ir->blocks[blk];
+        work[(*nwork)++] = blk;
+    }
+}
+
+/* Whether block `from`, whose ops end at `end[from]`, jumps to block
+ * `to`. */
+static bool ir_jumps(const ir_t *ir, const uint32_t *end, uint32_t from,
+                     uint32_t to)
+{
+    if(end[from] == IR_NOREG || end[from] == 0) {
+        return false;
+    }
+    const irins_t *in = &ir->ins[end[from] - 1];
+    return (ir_is_jump(in->op) && in->imm.blk[0] == to) ||
+           (in->op == IR_JNZ && in->imm.blk[1] == to);
+}
+
+/* Drop what can never run: functions `main` doesn't call, directly or
+ * not, blocks nothing jumps to, and whatever comes after the op that
+ * ends a block. Phis forget the blocks that don't jump to them any
+ * more. */
+void ir_prune(ir_t *ir)
+{
+    size_t nb = size_max(ir->nblocks, 1);
+    /* one past the last op of every block that runs, IR_NOREG for the
+     * others */
+    uint32_t *end = arena_alloc(&ir->arena, nb * sizeof(*end));
+    memset(end, 0xff, nb * sizeof(*end));
+    uint32_t *work = arena_alloc(&ir->arena, nb * sizeof(*work));
+    size_t nwork = 0;
+    bool *called = arena_alloc(&ir->arena, size_max(ir->nfuncs, 1));
+    memset(called, 0, size_max(ir->nfuncs, 1));
+
+    /* everything starts at the top of `main` */
+    ir_reach(ir, end, work, &nwork, 0);
+    while(nwork > 0) {
+        uint32_t blk = work[--nwork];
+        size_t i = blk == 0 ? 0 : ir->blocks[blk] + 1;
+        for(; i < ir->size; i++) {
+            const irins_t *in = &ir->ins[i];
+            /* only the end of `main` runs into one */
+            if(in->op == IR_LABEL || in->op == IR_FUNC) {
+                break;
+            }
+            if((in->op == IR_CALLF || in->op == IR_TAIL) &&
+               !called[in->imm.func.fn]) {
+                const irfunc_t *f = &ir->funcs[in->imm.func.fn];
+                called[in->imm.func.fn] = true;
+                ir_reach(ir, end, work, &nwork,
+                         ir->ins[f->start].imm.func.blk);
+            }
+            if(ir_is_jump(in->op)) {
+                ir_reach(ir, end, work, &nwork, in->imm.blk[0]);
+            }
+            if(in->op == IR_JNZ) {
+                ir_reach(ir, end, work, &nwork, in->imm.blk[1]);
+            }
+            if(ir_ends_block(in->op)) {
+                i++;
+                break;
+            }
+        }
+        end[blk] = (uint32_t)i;
+    }
+
+    /* the phis first, while every block's jump is still in its place */
+    for(uint32_t blk = 1; blk < ir->nblocks; blk++) {
+        if(end[blk] == IR_NOREG) {
+            continue;
+        }
+        for(size_t i = ir->blocks[blk] + 1;
+            i < end[blk] && ir->ins[i].op == IR_PHI; i++) {
+            irins_t *phi = &ir->ins[i];
+            if(phi->b != IR_NOREG &&
+               !ir_jumps(ir, end, phi->imm.blk[1], blk)) {
+                phi->b = IR_NOREG;
+            }
+            if(!ir_jumps(ir, end, phi->imm.blk[0], blk)) {
+                phi->a = phi->b;
+                phi->imm.blk[0] = phi->imm.blk[1];
+                phi->b = IR_NOREG;
+            }
+        }
+    }
+
+    size_t n = 0;
+    uint32_t blk = 0;
+    for(size_t i = 0; i < ir->size; i++) {
+        const irins_t *in = &ir->ins[i];
+        if(in->op == IR_LABEL) {
+            blk = in->imm.blk[0];
+        } else if(in->op == IR_FUNC) {
+            blk = in->imm.func.blk;
+        }
+        if(end[blk] != IR_NOREG && i < end[blk]) {
+            ir->ins[n++] = *in;
+        }
+    }
+    ir->size = n;
+    ir_index_blocks(ir);
+}
+
+/* Whether anything in `ir` prints, and needs the format string. */
+bool ir_prints(const ir_t *ir)
+{
+    for(size_t i = 0; i < ir->size; i++) {
+        if(ir->ins[i].op == IR_DUMP) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Print register `r` to `to`, or nothing if it's unused. */
+static void dump_reg(FILE *to, const char *sep, uint32_t r)
+{
+    if(r != IR_NOREG) {
+        fprintf(to, "%sv%" PRIu32, sep, r);
+    }
+}
+
+/* Print `ir` in a readable form to `to`, for debugging. */
+void ir_dump(const ir_t *ir, FILE *to)
+{
+    fprintf(to, "; %zu ops, %" PRIu32 " vregs, %" PRIu32 " deep\n", ir->size,
+            ir->nvregs, ir->maxdepth);
+    for(size_t i = 0; i < ir->size; i++) {
+        const irins_t *in = &ir->ins[i];
+        fprintf(to, "%5zu [%3" PRId32 "] ", i, in->depth);
+        if(in->dst != IR_NOREG) {
+            fprintf(to, "v%" PRIu32 " = ", in->dst);
+        }
+        fprintf(to, "%s%s", in->uns ? "u" : "", ir_opname(in->op));
+        if(ir_is_binop(in->op) && in->a == IR_NOREG) {
+            fprintf(to, " %" PRId64, in->imm.i);
+        }
+        if(in->op == IR_PHI) {
+            fprintf(to, " b%" PRIu32, in->imm.blk[0]);
+            dump_reg(to, " ", in->a);
+            if(in->b != IR_NOREG) {
+                fprintf(to, ", b%" PRIu32, in->imm.blk[1]);
+                dump_reg(to, " ", in->b);
+            }
+            fputc('\n', to);
+            continue;
+        }
+        dump_reg(to, " ", in->a);
+        dump_reg(to, ", ", in->b);
+        switch(in->op) {
+        case IR_ICONST:
+            fprintf(to, " %" PRId64, in->imm.i);
+            break;
+        case IR_UCONST:
+            fprintf(to, " %" PRIu64, in->imm.u);
+            break;
+        case IR_CALL:
+            fprintf(to, " $%.*s", (int)in->imm.sym.len, ir_sym(ir, in));
+            break;
+        case IR_FUNC:
+        case IR_CALLF:
+        case IR_TAIL: {
+            const irfunc_t *f = &ir->funcs[in->imm.func.fn];
+            fprintf(to, " $%.*s", (int)f->len, ir_fname(ir, f));
+            if(in->op == IR_FUNC) {
+                fprintf(to, " b%" PRIu32, in->imm.func.blk);
+            }
+            break;
+        }
+        case IR_PARAM:
+        case IR_EXT:
+            fprintf(to, " %" PRId64, in->imm.i);
+            break;
+        case IR_LABEL:
+        case IR_JMP:
+            fprintf(to, " b%" PRIu32, in->imm.blk[0]);
+            break;
+        case IR_JNZ:
+            fprintf(to, ", b%" PRIu32 ", b%" PRIu32, in->imm.blk[0],
+                    in->imm.blk[1]);
+            break;
+        default:
+            break;
+        }
+        fputc('\n', to);
+    }
+}
+
+/* Free `ir`. */
+void ir_free(ir_t *ir)
+{
+    arena_free(&ir->arena);
+    intern_free(&ir->names);
+    memset(ir, 0, sizeof(*ir));
+}
@@ -0,0 +1,268 @@
+/*
+ * Copyright (C) 2025 therealblue24.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Header file for the stack-machine IR.
+ *
+ * The IR is a flat array of ops, one per token at most, built in a
+ * single pass over the lexer's tokens. Every op names the virtual
+ * registers it reads and writes, and carries the stack depth in front
+ * of it, so later passes and backends never have to simulate the stack
+ * again. Virtual registers are SSA values: each one is written by
+ * exactly one op.
+ *
+ * Binops whose `a` is IR_NOREG take `imm.i` for it instead: `N op`
+ * fuses into one op that way (see fuse.h), and the optimizer leaves
+ * constants there too.
+ *
+ * Control flow splits the ops into blocks: block 0 starts at the top,
+ * every other one at its IR_LABEL. Blocks end in IR_JMP, IR_JNZ, IR_RET
+ * or IR_TAIL, and nothing comes after that until the next label, since
+ * `ir_prune` drops what can't run; only `main` runs off its end, and
+ * there's no falling into a label. Right after its label, a block has
+ * one IR_PHI per stack slot, bottom first, with the value each live
+ * predecessor leaves in that slot; every value on the stack comes in
+ * through those, so a backend can hand the whole stack over at each
+ * jump without tracking it.
+ *
+ * The top level is function 0, `main`, and its ops come first. Every
+ * `func` follows with its own ops, starting at its IR_FUNC, which also
+ * starts its first block: a function's parameters are IR_PARAMs at the
+ * bottom of its stack, and every way out of it is an IR_RET. A call
+ * passes its arguments in the IR_ARGs right before it, first one
+ * first. Block and register numbers are the same across functions.
+ *
+ * A call whose result is returned right away is an IR_TAIL, which is
+ * the last op of its block: a call to the function it's in loops back
+ * to the top, and any other can jump instead of calling.
+ *
+ * Divisions and comparisons are signed, unless `uns` is set: then
+ * neither side can be negative, going by the types (see width.h), and
+ * they're unsigned. That's settled once `ir_build` is done, so the
+ * optimizer can't change what a program does.
+ */
+#ifndef IR_H_
+#define IR_H_
+
+#include "util.h"
+#include "arena.h"
+#include "lex.h"
+#include "fuse.h"
+
+/* operand slot that isn't used */
+#define IR_NOREG UINT32_MAX
+
+/* IR operations. */
+enum irop {
+    IR_NOP, /* nothing, left behind by passes */
+    IR_ICONST, /* dst = imm.i */
+    IR_UCONST, /* dst = imm.u */
+    IR_ADD, /* dst = a + b */
+    IR_SUB, /* dst = a - b */
+    IR_MUL, /* dst = a * b */
+    IR_DIV, /* dst = a / b */
+    IR_EQ, /* dst = a == b, 1 or 0 */
+    IR_NE, /* dst = a != b */
+    IR_LT, /* dst = a < b */
+    IR_LE, /* dst = a <= b */
+    IR_GT, /* dst = a > b */
+    IR_GE, /* dst = a >= b */
+    IR_DUP, /* pushes a again, no code */
+    IR_DROP, /* pops a, no code */
+    IR_DROPALL, /* empties the stack, no code */
+    IR_SWAP, /* swaps a and b, no code */
+    IR_OVER, /* pushes b again, no code */
+    IR_DUMP, /* print a */
+    IR_CALL, /* dst = sym() */
+    IR_RET, /* return a, if it isn't IR_NOREG */
+    IR_LABEL, /* start of block blk[0] */
+    IR_JMP, /* go to block blk[0] */
+    IR_JNZ, /* go to block blk[0] if a isn't 0, else to blk[1] */
+    IR_PHI, /* dst = a coming from block blk[0], b from blk[1] */
+    IR_FUNC, /* start of function func.fn, and of its block func.blk */
+    IR_PARAM, /* dst = parameter imm.i */
+    IR_ARG, /* a is the next argument of the call coming up */
+    IR_CALLF, /* dst = function func.fn(args), IR_NOREG if it returns
+               * nothing */
+    IR_EXT, /* dst = a cut down to IRT_* imm.i and extended back */
+    IR_TAIL, /* return what function func.fn(args) returns */
+
+    IR_COUNT,
+};
+
+/* One op. 32 bytes. */
+typedef struct irins {
+    uint8_t op; /* IR_* */
+    bool uns; /* unsigned division or comparison, see above */
+    uint8_t pad_[2];
+    int32_t depth; /* stack depth in front of the op */
+    uint32_t dst, a, b; /* virtual registers, IR_NOREG if unused */
+    uint32_t tok; /* token the op came from, for diagnostics */
+    union {
+        int64_t i; /* IR_ICONST, binops without `a` */
+        uint64_t u; /* IR_UCONST */
+        struct {
+            uint32_t off, len; /* name in the source */
+        } sym; /* IR_CALL */
+        uint32_t blk[2]; /* control flow, see above */
+        struct {
+            uint32_t blk, fn;
+        } func; /* IR_FUNC, IR_CALLF, IR_TAIL */
+    } imm;
+} irins_t;
+
+/* Types of parameters and return values, as far as calls go. Inside a
+ * function every value is 64 bits, and narrower ones are extended to
+ * that on the way in. */
+enum irty {
+    IRT_NONE, /* returns nothing */
+    IRT_L, /* 64 bits */
+    IRT_UL, /* 64, unsigned */
+    IRT_W, /* 32, signed */
+    IRT_UW, /* 32, unsigned */
+    IRT_H, /* 16, signed */
+    IRT_UH, /* 16, unsigned */
+    IRT_B, /* 8, signed */
+    IRT_UB, /* 8, unsigned */
+};
+
+/* Whether IRT_* `ty` is 64 bits, so values of it need no extending. */
+static inline bool ir_wide(int ty)
+{
+    return ty == IRT_L || ty == IRT_UL;
+}
+
+/* A function. */
+typedef struct irfunc {
+    uint32_t off, len; /* name in the source */
+    uint8_t *params; /* IRT_* of every parameter */
+    uint32_t nparams;
+    uint8_t ret; /* IRT_* */
+    bool leaf; /* calls nothing */
+    uint32_t start; /* index of its first op, IR_NOREG once it's gone
+                     * (see `ir_prune`) */
+    uint32_t maxdepth; /* deepest its stack gets */
+    uint32_t body, end; /* its tokens, from the first of the body to
+                         * its `end` */
+} irfunc_t;
+
+/* Whole-program IR. */
+typedef struct ir {
+    arena_t arena; /* backs `ins` and whatever passes need */
+    irins_t *ins;
+    size_t size, cap;
+    const uint8_t *src; /* input the `sym`s point into */
+    uint32_t nvregs; /* virtual registers are 0..nvregs-1 */
+    uint32_t maxdepth; /* deepest the stack gets */
+    uint32_t *blocks; /* index of each block's first op */
+    uint32_t nblocks;
+    irfunc_t *funcs; /* `main` first */
+    uint32_t nfuncs;
+    intern_t names; /* of the functions, ID `k` is `funcs[k + 1]` */
+    fusestats_t fused; /* sequences `ir_build` fused */
+} ir_t;
+
+/* Name of op `op`. */
+const char *ir_opname(int op);
+
+/* Build `ir` from the tokens of `lex`, reporting errors through it.
+ * Returns nonzero on failure. */
+int ir_build(ir_t *ir, lex_t *lex);
+
+/* Print `ir` in a readable form to `to`, for debugging. */
+void ir_dump(const ir_t *ir, FILE *to);
+
+/* Work out `ir->blocks` and where functions start again, after ops
+ * moved around. */
+void ir_index_blocks(ir_t *ir);
+
+/* Drop what can never run: functions `main` doesn't call, directly or
+ * not, blocks nothing jumps to, and whatever comes after the op that
+ * ends a block. Phis forget the blocks that don't jump to them any
+ * more. */
+void ir_prune(ir_t *ir);
+
+/* Whether anything in `ir` prints, and needs the format string. */
+bool ir_prints(const ir_t *ir);
+
+/* Free `ir`. */
+void ir_free(ir_t *ir);
+
+/* Whether op `op` turns into any code. */
+static inline bool ir_has_code(int op)
+{
+    return op != IR_NOP && op != IR_DUP && op != IR_DROP &&
+           op != IR_DROPALL && op != IR_SWAP && op != IR_OVER;
+}
+
+/* Whether op `op` is a comparison. */
+static inline bool ir_is_cmp(int op)
+{
+    return op >= IR_EQ && op <= IR_GE;
+}
+
+/* Whether op `op` is a binop, comparisons included. */
+static inline bool ir_is_binop(int op)
+{
+    return (op >= IR_ADD && op <= IR_DIV) || ir_is_cmp(op);
+}
+
+/* Whether op `op` ends its block. */
+static inline bool ir_is_jump(int op)
+{
+    return op == IR_JMP || op == IR_JNZ;
+}
+
+/* Whether op `op` is the last one of its block. */
+static inline bool ir_ends_block(int op)
+{
+    return ir_is_jump(op) || op == IR_RET || op == IR_TAIL;
+}
+
+/* Name of the function op `ins` calls. */
+static inline const uint8_t *ir_sym(const ir_t *ir, const irins_t *ins)
+{
+    return ir->src + ins->imm.sym.off;
+}
+
+/* `v` cut down to IRT_* `ty` and extended back to 64 bits. */
+static inline int64_t ir_narrow(int ty, int64_t v)
+{
+    switch(ty) {
+    case IRT_W:
+        return (int32_t)v;
+    case IRT_UW:
+        return (uint32_t)v;
+    case IRT_H:
+        return (int16_t)v;
+    case IRT_UH:
+        return (uint16_t)v;
+    case IRT_B:
+        return (int8_t)v;
+    case IRT_UB:
+        return (uint8_t)v;
+    default:
+        return v;
+    }
+}
+
+/* Function of `funcs` called `name`, going by `names` (see `ir_t`), or
+ * NULL if there's none. */
+static inline const irfunc_t *ir_lookup(const irfunc_t *funcs,
+                                        const intern_t *names,
+                                        const uint8_t *name, size_t len)
+{
+    uint32_t id = intern_find(names, name, len);
+    return id == INTERN_NONE ? NULL : &funcs[id + 1];
+}
+
+/* Name of function `f`. */
+static inline const uint8_t *ir_fname(const ir_t *ir, const irfunc_t *f)
+{
+    return ir->src + f->off;
+}
+
+#endif /* IR_H_ */
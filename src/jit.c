@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2025 therealblue24.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * In-memory JIT: machine code from the x86-64 backend, mapped W^X.
+ */
+/* RTLD_DEFAULT */
+#define _GNU_SOURCE
+#include "jit.h"
+#include "cg.h"
+#include <dlfcn.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+/* Address of the function named by the `len` bytes at `off` in the
+ * source of `lex`, in the running process. `lex` gets the complaint
+ * if there's none. */
+const void *jit_lookup(lex_t *lex, uint32_t off, uint32_t len)
+{
+    const char *name = (const char *)lex->buf + off;
+
+    /* the name is in the middle of the source, dlsym wants a string */
+    char small[64];
+    char *s = len < sizeof(small) ? small : zalloc(len + 1);
+    memcpy(s, name, len);
+    s[len] = '\0';
+    const void *addr = dlsym(RTLD_DEFAULT, s);
+    if(s != small) {
+        free(s);
+    }
+
+    if(!addr) {
+        LEX_ERR(lex, off, len, "no function named `%.*s`", (int)len, name);
+    }
+    return addr;
+}
+
+static const void *jit_resolve(void *ctx, const irins_t *in)
+{
+    return jit_lookup(ctx, in->imm.sym.off, in->imm.sym.len);
+}
+
+/* Compile `ir` into `j`, reporting functions that don't exist
+ * through `lex`.
+ * Returns nonzero on failure. */
+int jit_compile(jit_t *j, const ir_t *ir, lex_t *lex)
+{
+    memset(j, 0, sizeof(*j));
+    uint8_t *code;
+    size_t size;
+    if(cg_x64_code(ir, jit_resolve, lex, &code, &size)) {
+        free(code);
+        return 1;
+    }
+
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    j->size = (size + page - 1) / page * page;
+    j->mem = mmap(NULL, j->size, PROT_READ | PROT_WRITE,
+                  MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(j->mem == MAP_FAILED) {
+        j->mem = NULL;
+        free(code);
+        return 1;
+    }
+    memcpy(j->mem, code, size);
+    free(code);
+
+    /* written, now it only gets to run */
+    if(mprotect(j->mem, j->size, PROT_READ | PROT_EXEC)) {
+        jit_free(j);
+        return 1;
+    }
+    /* POSIX says data and function pointers convert */
+    j->entry = (int64_t (*)(void))j->mem;
+    return 0;
+}
+
+/* Free `j`. */
+void jit_free(jit_t *j)
+{
+    if(j->mem) {
+        munmap(j->mem, j->size);
+    }
+    memset(j, 0, sizeof(*j));
+}
@@ -0,0 +1,48 @@
+/*
+ * Copyright (C) 2025 therealblue24.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Header file for the in-memory JIT.
+ *
+ * The x86-64 backend assembles the IR straight into an anonymous
+ * mapping, which is writable while the code goes in and executable
+ * afterwards, never both. Called functions are looked up in the
+ * running process, so `dump` and builtins call the host's own.
+ */
+#ifndef JIT_H_
+#define JIT_H_
+
+#include "util.h"
+#include "ir.h"
+#include "lex.h"
+
+/* Compiled program. */
+typedef struct jit {
+    void *mem; /* the mapping */
+    size_t size; /* of `mem` */
+    int64_t (*entry)(void); /* the program, returns what `ret` did */
+} jit_t;
+
+/* Address of the function named by the `len` bytes at `off` in the
+ * source of `lex`, in the running process. `lex` gets the complaint
+ * if there's none. */
+const void *jit_lookup(lex_t *lex, uint32_t off, uint32_t len);
+
+/* Compile `ir` into `j`, reporting functions that don't exist
+ * through `lex`.
+ * Returns nonzero on failure. */
+int jit_compile(jit_t *j, const ir_t *ir, lex_t *lex);
+
+/* Run `j`, returning what the program returns. */
+static inline int64_t jit_run(const jit_t *j)
+{
+    return j->entry();
+}
+
+/* Free `j`. */
+void jit_free(jit_t *j);
+
+#endif /* JIT_H_ */
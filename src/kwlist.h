@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2025 therealblue24.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * List of keywords, the one place they're spelled out.
+ *
+ * `KEYWORDS(K)` calls `K(nam, tok)` for every keyword, in the order of
+ * their `enum toktype` members, which lex.h makes out of it as
+ * `TOK_##tok`; tools/kwgen.c makes the perfect-hash table (src/kwtab.h)
+ * out of it too. Add new keywords here.
+ */
+#ifndef KWLIST_H_
+#define KWLIST_H_
+
+/* uint<x>_t and int<x>_t */
+#define KEYWORDS_INTN(K, x)        \
+    K("uint" #x "_t", UINT##x##_T) \
+    K("int" #x "_t", INT##x##_T)
+
+#define KEYWORDS(K)                                                       \
+    K("func", FUNC)                                                       \
+    K("->", ARROW)                                                        \
+    K("do", DO)                                                           \
+    K("then", THEN) /* do but for if loops */                             \
+    K("end", END)                                                         \
+    K("if", IF)                                                           \
+    K("else", ELSE)                                                       \
+    K("while", WHILE)                                                     \
+    K("dup", DUP)                                                         \
+    K("drop", DROP)                                                       \
+    K("dropall", DROPALL)                                                 \
+    K("swap", SWAP)                                                       \
+    K("over", OVER)                                                       \
+    K("ret", RET)                                                         \
+    /* -- types -- */                                                     \
+    K("char", CHAR)                                                       \
+    K("uchar", UCHAR) /* unsigned char */                                 \
+    K("short", SHORT)                                                     \
+    K("ushort", USHORT) /* unsigned short */                              \
+    K("int", INT)                                                         \
+    K("uint", UINT) /* unsigned int */                                    \
+    /* long here is 64-bit.  windows users can use WSL */                 \
+    K("long", LONG)                                                       \
+    K("ulong", ULONG) /* unsigned long */                                 \
+    K("str", STR) /* void* but fancy */                                   \
+    K("ptr", PTR) /* void* */                                             \
+    K("none", NONE) /* void */                                            \
+    K("size_t", SIZE_T)                                                   \
+    K("intmax_t", INTMAX_T)                                               \
+    K("uintmax_t", UINTMAX_T)                                             \
+    /* -- *int*_t -- */                                                   \
+    KEYWORDS_INTN(K, 8)                                                   \
+    KEYWORDS_INTN(K, 16)                                                  \
+    KEYWORDS_INTN(K, 32)                                                  \
+    KEYWORDS_INTN(K, 64)                                                  \
+    /* arithmetic operators */                                            \
+    K("+", ADD)                                                           \
+    K("-", SUB)                                                           \
+    K("*", MUL)                                                           \
+    K("/", DIV)                                                           \
+    /* comparisons, 1 if true and 0 if not */                             \
+    K("=", EQ)                                                            \
+    K("!=", NE)                                                           \
+    K("<", LT)                                                            \
+    K("<=", LE)                                                           \
+    K(">", GT)                                                            \
+    K(">=", GE)                                                           \
+    K("dump", DUMP) /* dump to stdout */
+
+#endif /* KWLIST_H_ */
@@ -0,0 +1,75 @@
+/* Generated from `tools/kwgen.c`, do not edit. */
+#ifndef KWTAB_H_
+#define KWTAB_H_
+
+#define KW_SEED 11112u
+#define KW_TABSZ 128
+#define KW_MAXLEN 9
+#define KW_COUNT 47
+
+struct kwslot {
+    char nam[KW_MAXLEN + 1];
+    uint8_t len; /* zero if the slot is empty */
+    uint8_t tok;
+};
+
+static inline uint32_t kw_hash(const uint8_t *s, size_t len)
+{
+    uint32_t h = KW_SEED ^ (uint32_t)len;
+    for(size_t i = 0; i < len; i++) {
+        h = (h ^ s[i]) * 0x01000193u;
+    }
+    return (h ^ (h >> 15)) & (KW_TABSZ - 1);
+}
+
+static const struct kwslot kwtab[KW_TABSZ] = {
+    [  0] = { "ulong", 5, TOK_ULONG },
+    [  4] = { "-", 1, TOK_SUB },
+    [  5] = { "int8_t", 6, TOK_INT8_T },
+    [  7] = { "over", 4, TOK_OVER },
+    [ 10] = { "ushort", 6, TOK_USHORT },
+    [ 17] = { "ret", 3, TOK_RET },
+    [ 21] = { "uintmax_t", 9, TOK_UINTMAX_T },
+    [ 25] = { "intmax_t", 8, TOK_INTMAX_T },
+    [ 26] = { "do", 2, TOK_DO },
+    [ 27] = { "while", 5, TOK_WHILE },
+    [ 33] = { "size_t", 6, TOK_SIZE_T },
+    [ 35] = { "if", 2, TOK_IF },
+    [ 41] = { "uint64_t", 8, TOK_UINT64_T },
+    [ 43] = { "end", 3, TOK_END },
+    [ 44] = { "uint", 4, TOK_UINT },
+    [ 45] = { ">=", 2, TOK_GE },
+    [ 47] = { "int32_t", 7, TOK_INT32_T },
+    [ 48] = { "int64_t", 7, TOK_INT64_T },
+    [ 52] = { "=", 1, TOK_EQ },
+    [ 53] = { "none", 4, TOK_NONE },
+    [ 56] = { "func", 4, TOK_FUNC },
+    [ 57] = { "int", 3, TOK_INT },
+    [ 58] = { "/", 1, TOK_DIV },
+    [ 59] = { "char", 4, TOK_CHAR },
+    [ 60] = { "then", 4, TOK_THEN },
+    [ 67] = { "ptr", 3, TOK_PTR },
+    [ 68] = { "<=", 2, TOK_LE },
+    [ 71] = { "<", 1, TOK_LT },
+    [ 72] = { "dump", 4, TOK_DUMP },
+    [ 73] = { "drop", 4, TOK_DROP },
+    [ 76] = { "uint32_t", 8, TOK_UINT32_T },
+    [ 77] = { "str", 3, TOK_STR },
+    [ 80] = { "int16_t", 7, TOK_INT16_T },
+    [ 86] = { "uchar", 5, TOK_UCHAR },
+    [ 87] = { "!=", 2, TOK_NE },
+    [ 91] = { "short", 5, TOK_SHORT },
+    [ 92] = { "uint16_t", 8, TOK_UINT16_T },
+    [ 94] = { "->", 2, TOK_ARROW },
+    [ 95] = { "else", 4, TOK_ELSE },
+    [ 96] = { "dup", 3, TOK_DUP },
+    [ 97] = { "uint8_t", 7, TOK_UINT8_T },
+    [102] = { "long", 4, TOK_LONG },
+    [110] = { "+", 1, TOK_ADD },
+    [113] = { "*", 1, TOK_MUL },
+    [116] = { "dropall", 7, TOK_DROPALL },
+    [122] = { "swap", 4, TOK_SWAP },
+    [125] = { ">", 1, TOK_GT },
+};
+
+#endif /* KWTAB_H_ */
@@ -10,56 +10,15 @@
 
 #include "lex.h"
 #include "util.h"
+#include "scan.h"
+#include "num.h"
 #include <ctype.h>
 
-#define X(x)                                 \
-    { "int" xstr(x) "_t", TOK_INT##x##_T },  \
-    {                                        \
-        "uint" xstr(x) "_t", TOK_UINT##x##_T \
-    }
+/* Generated from `tools/kwgen.c`, see the Makefile. */
+#include "kwtab.h"
 
-struct keywordpair {
-    const char *nam;
-    const size_t map;
-};
-
-static const struct keywordpair keywords[] = {
-    { "+",         TOK_ADD       },
-    { "-",         TOK_SUB       },
-    { "*",         TOK_MUL       },
-    { "/",         TOK_DIV       },
-    { "dup",       TOK_DUP       },
-    { "drop",      TOK_DROP      },
-    { "dropall",   TOK_DROPALL   },
-    { "ret",       TOK_RET       },
-    { "dump",      TOK_DUMP      },
-    { "do",        TOK_DO        },
-    { "end",       TOK_END       },
-    { "func",      TOK_FUNC      },
-    { "->",        TOK_ARROW     },
-    { "char",      TOK_CHAR      },
-    { "uchar",     TOK_UCHAR     },
-    { "short",     TOK_SHORT     },
-    { "ushort",    TOK_USHORT    },
-    { "int",       TOK_INT       },
-    { "uint",      TOK_UINT      },
-    { "long",      TOK_LONG      },
-    { "ulong",     TOK_ULONG     },
-    { "str",       TOK_STR       },
-    { "ptr",       TOK_PTR       },
-    { "none",      TOK_NONE      },
-    { "size_t",    TOK_SIZE_T    },
-    { "intmax_t",  TOK_INTMAX_T  },
-    { "uintmax_t", TOK_UINTMAX_T },
-    X(8),
-    X(16),
-    X(32),
-    X(64)
-};
-
-#undef X
-
-static const size_t keyword_count = sizeof(keywords) / sizeof(keywords[0]);
+/* token types are stored in a byte */
+_Static_assert(TOK__COUNTR <= UINT8_MAX, "too many token types");
 
 static char def_name[] = "<unknown>";
 
@@ -73,28 +32,30 @@ lex_t *lex_create(void)
     lex->scap = 1024;
     lex->strlit = zalloc(lex->scap);
 
-    /* allocate `split` list */
-    lex->split.cap = 1024;
-    lex->split.size = 0;
-    lex->split.elems = zcalloc(lex->split.cap, sizeof(view_t));
+    /* `split` is only filled in when `keep_split` is set */
+    lex->split.elems = NULL;
+    lex->split.size = lex->split.cap = 0;
+    lex->keep_split = false;
+
+    /* decoded string literals */
+    intern_init(&lex->strs);
 
-    /* allocate `lines` list */
-    lex->lines.cap = 1024;
-    lex->lines.size = 0;
-    lex->lines.elems = zcalloc(lex->lines.cap, sizeof(size_t));
-    list_append(&lex->lines, -1); /* error val */
+    /* the line index is built on the first diagnostic */
+    memset(&lex->lines, 0, sizeof(lex->lines));
 
-    /* don't allocate the `toks` list, we do that later */
-    lex->toks.elems = NULL;
-    lex->toks.size = lex->toks.cap = 0;
+    /* don't allocate the `toks` store, we do that later */
+    memset(&lex->toks, 0, sizeof(lex->toks));
 
     /* init lexer state */
 
-    lex->col = 0;
-    lex->line = 1; /* lines are 1-indexed */
     lex->buf = NULL; /* don't have info */
     lex->name = NULL; /* don't have info */
     lex->pos = lex->len = lex->range = 0; /* don't have info */
+    lex->last = 0;
+    lex->quiet = false;
+
+    /* pick the scanner now, not racing on first use in some thread */
+    scan_init();
 
     return lex;
 }
@@ -106,8 +67,13 @@ int lex_supply_src(lex_t *lex, const uint8_t *src, size_t len)
     if(!lex || !src) {
         return 1;
     }
+    /* tokens store 32-bit offsets */
+    if(len > UINT32_MAX) {
+        return 1;
+    }
     lex->buf = src;
     lex->len = len;
+    srcmap_init(&lex->lines, src, len);
     return 0;
 }
 
@@ -122,65 +88,19 @@ int lex_supply_name(lex_t *lex, const char *name)
     return 0;
 }
 
-/* Save lexing state.    ss = Store   State */
-static void lex_ss(lex_t *lex)
-{
-    lex->ss_col = lex->col;
-    lex->ss_line = lex->line;
-    lex->ss_pos = lex->pos;
-}
-
-/* Restore lexing state. rs = Restore State */
-static void lex_rs(lex_t *lex)
-{
-    lex->col = lex->ss_col;
-    lex->line = lex->ss_line;
-    lex->pos = lex->ss_pos;
-}
-
-/* Returns if `c` is whitespace. */
-static int iswhitespace(int c)
-{
-    return isspace(c);
-}
-
-static int isnewline(int c)
-{
-    return c == '\n';
-}
-
-/* Get next character in lexer. */
-static int lex_nextchar(lex_t *lex)
+/* Look up keyword `src` with length `len`.
+ * Returns its TOK_* type, or -1 if it is not a keyword. */
+int lex_lookup_keyword(const uint8_t *src, size_t len)
 {
-    /* If we hit EOF */
-    if(lex->pos >= lex->len) {
-        return EOF;
+    /* anything longer can't be a keyword, don't bother hashing it */
+    if(len == 0 || len > KW_MAXLEN) {
+        return -1;
     }
-    /* Increase column. */
-    lex->col++;
-
-    int c = lex->buf[lex->pos++]; /* get char */
-
-    /* If newline, increase line and set col to zero. also
-     * append line info */
-    if(isnewline(c)) {
-        list_append(&lex->lines, lex->col - 1);
-        lex->line++;
-        lex->col = 0;
+    const struct kwslot *slot = &kwtab[kw_hash(src, len)];
+    if(slot->len != len || memcmp(slot->nam, src, len) != 0) {
+        return -1;
     }
-
-    return c;
-}
-
-/* Peek next character in lexer. */
-static int lex_peekchar(lex_t *lex)
-{
-    /* If we hit EOF */
-    if(lex->pos >= lex->len) {
-        return EOF;
-    }
-
-    return lex->buf[lex->pos];
+    return slot->tok;
 }
 
 static int lex_eof(lex_t *lex)
@@ -192,47 +112,49 @@ static int lex_eof(lex_t *lex)
     }
 }
 
+/* Move the lexer forward to `to`. Lines are worked out later, by
+ * `lex_loc`, only if anybody asks. */
+static void lex_advance(lex_t *lex, size_t to)
+{
+    lex->pos = to;
+}
+
 /* Skip until a non-whitespace character in `lex`. */
 static void lex_trim_whitespace(lex_t *lex)
 {
-    lex_ss(lex);
-    int c = ' ';
-    while(iswhitespace(c) && c != EOF) {
-        /* Next character, please. */
-        c = lex_nextchar(lex);
-        if(iswhitespace(c)) {
-            lex_ss(lex);
-        } else {
-            lex_rs(lex);
-            return;
-        }
-    }
-    return; /* done */
+    lex_advance(lex, scan_nonws(lex->buf, lex->pos, lex->len));
 }
 
 static void lex_trim_singleline_comment(lex_t *lex)
 {
     /* 1-liner in disguise */
-    while(!lex_eof(lex) && lex_peekchar(lex) != '\n') {
-        (void)lex_nextchar(lex);
-    }
-    return;
+    lex_advance(lex, scan_newline(lex->buf, lex->pos, lex->len));
 }
 
 static void lex_trim_multiline_comment(lex_t *lex)
 {
+    const uint8_t *buf = lex->buf;
+    size_t len = lex->len;
+    size_t p = lex->pos;
     int stack = 1;
-    int c1 = lex_nextchar(lex);
-    int c2 = lex_nextchar(lex);
-    while(stack && !lex_eof(lex)) {
-        if(c1 == '/' && c2 == '*')
+    /* only '/' and '*' can change the nesting, jump between those */
+    while(stack) {
+        p = scan_comment(buf, p, len);
+        if(p + 1 >= len) {
+            p = len; /* unterminated, eat the rest */
+            break;
+        }
+        if(buf[p] == '/' && buf[p + 1] == '*') {
             stack++;
-        if(c1 == '*' && c2 == '/')
+            p += 2;
+        } else if(buf[p] == '*' && buf[p + 1] == '/') {
             stack--;
-        c1 = c2;
-        c2 = lex_nextchar(lex);
+            p += 2;
+        } else {
+            p++;
+        }
     }
-    return;
+    lex_advance(lex, p);
 }
 
 static void lex_trim_comment(lex_t *lex, int type)
@@ -244,281 +166,358 @@ static void lex_trim_comment(lex_t *lex, int type)
     return;
 }
 
-static bool lex_strlit_ending(int c1, int c2, int c3)
+/* Find the end of the string literal starting at `p` (the opening quote).
+ * Returns the offset right after the closing quote, or `len` if there is
+ * none, setting `cutoff`. */
+static size_t lex_strlit_end(const uint8_t *buf, size_t p, size_t len,
+                             bool *cutoff)
 {
-    const int quote = '\"';
-    const int slash = '\\';
-    int ending_naive = c3 == quote;
-    int esc = (c2 == slash) && ending_naive && (c1 != slash);
-    return ending_naive && !esc;
+    p++; /* opening quote */
+    while(p < len) {
+        /* only quotes and backslashes matter, jump between those */
+        p = scan_strlit(buf, p, len);
+        if(p >= len) {
+            break;
+        }
+        if(buf[p] == '\"') {
+            *cutoff = false;
+            return p + 1;
+        }
+        p += 2; /* backslash, skip whatever is escaped */
+    }
+    *cutoff = true;
+    return len;
 }
 
-static void lex_split_by_whitespace(lex_t *lex)
+/* Scan the next whitespace-separated lexeme into `v`, skipping comments.
+ * Returns 0 once there is nothing left to scan. */
+static int lex_scan(lex_t *lex, view_t *v)
 {
-#define RETURN_IF_EOF                               \
-    do {                                            \
-        if(lex_eof(lex)) {                          \
-            list_append(&lex->lines, lex->col - 1); \
-            return;                                 \
-        }                                           \
+#define RETURN_IF_EOF      \
+    do {                   \
+        if(lex_eof(lex)) { \
+            return 0;      \
+        }                  \
     } while(0);
+    const uint8_t *buf = lex->buf;
+    size_t len = lex->len;
+
     /* While there is still data to process. */
     while(!lex_eof(lex)) {
         lex_trim_whitespace(lex);
         RETURN_IF_EOF; /* yeah nothing to split anymore */
 
-        /* Store line start, column start, and position start. */
-
-        size_t line_start = lex->line;
-        size_t col_start = lex->col;
+        /* Store position start. */
         size_t start = lex->pos;
 
         /* Check if there is a comment. */
-
-        if(lex_peekchar(lex) == '/') {
-            lex_ss(lex); /* save state */
-            int c;
-            (void)lex_nextchar(lex); /* dont care about the '/' */
-            c = lex_nextchar(lex); /* the one we care about */
-            if(c == '/' || c == '*') {
-                /* found a comment! */
-                lex_trim_comment(lex, c);
-                continue;
-            } else {
-                /* too eager, go back */
-                lex_rs(lex);
-            }
+        if(buf[start] == '/' && start + 1 < len &&
+           (buf[start + 1] == '/' || buf[start + 1] == '*')) {
+            /* found a comment! */
+            lex_advance(lex, start + 2);
+            lex_trim_comment(lex, buf[start + 1]);
+            continue;
         }
 
         size_t end = start;
         bool cutoff = false;
 
         /* Check if there is a string. */
-        if(lex_peekchar(lex) == '\"') {
-            /* get current, next, and next next char */
-            int c1 = lex_nextchar(lex);
-            int c2 = lex_nextchar(lex);
-            int c3 = lex_nextchar(lex);
-            end += 2;
-            /* continue on until end of strlit or EOF */
-            while(!lex_eof(lex) && !lex_strlit_ending(c1, c2, c3)) {
-                c1 = c2;
-                c2 = c3;
-                c3 = lex_nextchar(lex);
-                end++;
-            }
-
-            cutoff = lex_eof(lex) && !lex_strlit_ending(c1, c2, c3);
-            end += !cutoff;
-        }
-
-        /* Go ahead until there is whitespace. */
-        while(!lex_eof(lex) && !iswhitespace(lex_nextchar(lex))) {
-            end++;
+        if(buf[start] == '\"') {
+            end = lex_strlit_end(buf, start, len, &cutoff);
         }
 
-        /* Ok there is whitespace now. Store line & column end. */
-        size_t line_end = lex->line;
-        size_t col_end = lex->col;
+        /* Go ahead until there is whitespace, and eat it. */
+        end = scan_ws(buf, end, len);
+        lex_advance(lex, end + (end < len));
 
-        view_t v; /* the view */
-        /* store all info */
-        v.start = start;
-        v.end = end;
-        v.line_start = line_start;
-        v.line_end = line_end;
-        v.col_start = col_start;
-        v.col_end = col_end;
-        v.cutoff = cutoff;
+        /* Ok there is whitespace now. */
+        v->start = start;
+        v->end = end;
+        v->cutoff = cutoff;
 
         /* qol */
-        v.range = end - start; /* end >= start; this is safe */
-        v.src = lex->buf + start;
+        v->range = end - start; /* end >= start; this is safe */
+        v->src = buf + start;
 
-        list_append(&lex->split, v);
-
-        RETURN_IF_EOF; /* there is nothing we can do */
+        return 1;
     }
-    return;
+    return 0;
+#undef RETURN_IF_EOF
 }
 
-/* Lex input.
+/* Fill in the fields every token kind shares. */
+static void lex_tok_init(lex_t *lex, token_t *tok, view_t v, int langtype,
+                         int toktype)
+{
+    (void)lex;
+    tok->langtype = langtype;
+    tok->toktype = toktype;
+    tok->raw = v.src;
+    tok->range = v.range;
+}
+
+/* Turn view `v` into token `tok`.
  * Returns nonzero on failure. */
-int lex_do(lex_t *lex)
+static int lex_classify(lex_t *lex, view_t v, token_t *tok)
 {
-    if(!lex) {
+    if(v.cutoff) {
+        LEX_ERR(lex, v.start, v.range, "cutoff string literal");
         return 1;
     }
 
-    if(!lex->buf) {
-        return 1;
-    }
+    int keyword = lex_lookup_keyword(v.src, v.range);
 
-    if(!lex->name) {
-        lex->name = def_name;
+    /* found one? */
+    if(keyword >= 0) {
+        /* nothing else to fill out */
+        lex_tok_init(lex, tok, v, TOKL_KEYWORD, keyword);
+        return 0;
     }
 
-    /* Spilt by whitespace; the main lexer.
-     * Definitely not the reason why I decided to make
-     * a stack based lang... definitely... */
-    lex_split_by_whitespace(lex);
-
-    /* For all the views we have lexed */
-    for(size_t i = 0; i < lex->split.size; i++) {
-        view_t v = lex->split.elems[i]; /* the view */
-        if(v.cutoff) {
-            COMP_ERR(lex->name, v.line_start, v.col_start, v.src,
-                     lex->lines.elems[v.line_start] - v.col_start, v.range,
-                     "cutoff string literal");
+    /* number, literal, or string literal. */
+    if(*v.src == '\"') {
+        /* string literal it is! */
+        lex_tok_init(lex, tok, v, TOKL_STRLIT, TOK_SPECIAL_STRLIT);
+        /* decode into the scratch buffer, then intern that */
+        if(v.range + 1 > lex->scap) {
+            lex->scap = size_max(lex->scap * 2, v.range + 1);
+            lex->strlit = zrealloc(lex->strlit, lex->scap);
+        }
+        size_t sz = strl_parse(tok->raw, lex->strlit, v.range);
+        if(sz == STRL_ERR) {
+            LEX_ERR(lex, v.start, v.range, "malformed string literal");
             return 1;
         }
+        lex->ssize = sz;
+        uint32_t id = intern_put(&lex->strs, lex->strlit, sz);
+        tok->tokl_strlit = intern_get(&lex->strs, id).str;
+        tok->tokl_strsz = sz;
+        tok->tokl_strid = id;
+        return 0;
+    }
 
-        bool keyword_found = false;
-        size_t keyword = 0;
-
-        /* try to find keywords */
-        for(size_t j = 0; j < keyword_count; j++) {
-            if(v.range == strnlen(keywords[j].nam, 100) &&
-               strncmp((const char *)v.src, keywords[j].nam, v.range) == 0) {
-                keyword_found = true;
-                keyword = j;
-                break;
-            }
+    /* number, maybe negative */
+    if(isdigit(*v.src) ||
+       (v.range >= 2 && *v.src == '-' && isdigit(v.src[1]))) {
+        num_t num;
+        int rc = num_parse(v.src, v.range, &num);
+        if(rc != NUM_OK) {
+            LEX_ERR(lex, v.start, v.range,
+                    rc == NUM_ERANGE ? "numeral out of range"
+                                     : "invalid numeral");
+            return 1;
         }
+        lex_tok_init(lex, tok, v, TOKL_NUM, num.toktype);
+        tok->tok_num.unsignd = num.unsignd; /* whole union */
+        return 0;
+    }
 
-        /* found one? */
-        if(keyword_found) {
-            /* emit it */
-            int type = keywords[keyword].map;
-            token_t tok;
-            /* copy over fields */
-            tok.langtype = TOKL_KEYWORD;
-            tok.toktype = type;
-            tok.line = v.line_start;
-            tok.col = v.col_start;
-            tok.line_end = v.line_end;
-            tok.col_end = v.col_end;
-            tok.filenam = lex->name;
-            tok.raw = v.src;
-            tok.range = v.range;
-            /* emit the token now, nothing else to fill out */
-            list_append(&lex->toks, tok);
-
-            continue; /* next possible token, please */
-        }
+    /* literal */
+    lex_tok_init(lex, tok, v, TOKL_LIT, TOK_SPECIAL_LIT);
+    tok->tokl_lit = tok->raw;
+    return 0;
+}
 
-        /* number, literal, or string literal. */
-        if(*v.src == '\"') {
-            /* string literal it is! */
-            token_t tok;
-            /* copy over fields */
-            tok.langtype = TOKL_STRLIT;
-            tok.toktype = TOK_SPECIAL_STRLIT;
-            tok.line = v.line_start;
-            tok.col = v.col_start;
-            tok.line_end = v.line_end;
-            tok.col_end = v.col_end;
-            tok.filenam = lex->name;
-            tok.raw = v.src;
-            tok.range = v.range;
-            void *scratch = zalloc(v.range + 1);
-            size_t sz = strl_parse(tok.raw, scratch, v.range);
-            if(sz == 0) {
-                COMP_ERR(lex->name, v.line_start, v.col_start, v.src,
-                         lex->lines.elems[v.line_start] - v.col_start, v.range,
-                         "malformed string literal");
-                return 1;
-            }
-            tok.tokl_strlit = scratch;
-            tok.tokl_strsz = sz;
-
-            /* append the str */
-            list_append(&lex->toks, tok);
-            continue;
-        }
+/* Lex the next token of the input into `tok`.
+ * Returns 1 if a token was lexed, 0 at the end of the input,
+ * and -1 on failure. */
+int lex_next(lex_t *lex, token_t *tok)
+{
+    if(!lex || !lex->buf) {
+        return -1;
+    }
 
-        /* negative number */
-        if(v.range >= 2 && *v.src == '-' && isdigit(v.src[1])) {
-            int64_t num = 0;
-            for(size_t k = 1; k < v.range; k++) {
-                num *= 10;
-                if(isdigit(v.src[k])) {
-                    num += v.src[k] - '0';
-                } else {
-                    /* TODO: Numbered literals */
-                    COMP_ERR(lex->name, v.line_start, v.col_start, v.src,
-                             lex->lines.elems[v.line_start] - v.col_start,
-                             v.range, "invalid numeral");
-                    return 1;
-                }
-            }
-            num = -num;
-            token_t tok;
-            /* copy over fields */
-            tok.langtype = TOKL_NUM;
-            tok.toktype = TOK_NUM_INT;
-            tok.line = v.line_start;
-            tok.col = v.col_start;
-            tok.line_end = v.line_end;
-            tok.col_end = v.col_end;
-            tok.filenam = lex->name;
-            tok.raw = v.src;
-            tok.range = v.range;
-            tok.tok_num.signd = num;
-            list_append(&lex->toks, tok);
-
-            continue; /* next possible token, please */
-        }
+    if(!lex->name) {
+        lex->name = def_name;
+    }
+
+    view_t v;
+    if(!lex_scan(lex, &v)) {
+        lex->last = lex->len;
+        return 0;
+    }
+    lex->last = v.start;
+
+    /* only the debug dump wants these */
+    if(lex->keep_split) {
+        list_append(&lex->split, v);
+    }
+
+    return lex_classify(lex, v, tok) ? -1 : 1;
+}
+
+/* Make room for `n` tokens in `ts`. */
+void tokstore_reserve(tokstore_t *ts, size_t n)
+{
+    /* grow all the parallel arrays together */
+    if(n > ts->cap) {
+        ts->cap = size_max(n, size_max(LIST_INITIAL_CAP, ts->cap * 2));
+        ts->type = zcrealloc(ts->type, ts->cap, sizeof(*ts->type));
+        ts->start = zcrealloc(ts->start, ts->cap, sizeof(*ts->start));
+        ts->len = zcrealloc(ts->len, ts->cap, sizeof(*ts->len));
+    }
+}
+
+/* Free the tokens in `ts`. */
+void tokstore_free(tokstore_t *ts)
+{
+    free(ts->type);
+    free(ts->start);
+    free(ts->len);
+    free(ts->payload.elems);
+    memset(ts, 0, sizeof(*ts));
+}
+
+/* Append token `tok` to `ts`, `base` being the start of the source. */
+void tokstore_push(tokstore_t *ts, const uint8_t *base, const token_t *tok)
+{
+    tokstore_reserve(ts, ts->size + 1);
+
+    size_t i = ts->size++;
+    ts->type[i] = (uint8_t)tok->toktype;
+    ts->start[i] = (uint32_t)(tok->raw - base);
+    ts->len[i] = (uint32_t)tok->range;
+
+    tokpayload_t p;
+    p.tok = (uint32_t)i;
+    switch(tok->langtype) {
+    case TOKL_NUM:
+        p.num.unsignd = tok->tok_num.unsignd;
+        list_append(&ts->payload, p);
+        break;
+    case TOKL_STRLIT:
+        p.strlit.str = tok->tokl_strlit;
+        p.strlit.size = tok->tokl_strsz;
+        p.strlit.id = tok->tokl_strid;
+        list_append(&ts->payload, p);
+        break;
+    default:
+        break;
+    }
+}
+
+/* Unpack token `i` with payload `p` (if it has one) into `tok`. */
+static void lex_unpack(const lex_t *lex, size_t i, const tokpayload_t *p,
+                       token_t *tok)
+{
+    const tokstore_t *ts = &lex->toks;
+    tok->toktype = ts->type[i];
+    tok->langtype = tok_langtype(tok->toktype);
+    tok->raw = lex->buf + ts->start[i];
+    tok->range = ts->len[i];
+    switch(tok->langtype) {
+    case TOKL_NUM:
+        tok->tok_num.unsignd = p->num.unsignd;
+        break;
+    case TOKL_STRLIT:
+        tok->tokl_strlit = p->strlit.str;
+        tok->tokl_strsz = p->strlit.size;
+        tok->tokl_strid = p->strlit.id;
+        break;
+    case TOKL_LIT:
+        tok->tokl_lit = tok->raw;
+        break;
+    default:
+        break;
+    }
+}
 
-        /* number */
-        if(isdigit(*v.src)) {
-            uint64_t num = 0;
-            for(size_t k = 0; k < v.range; k++) {
-                num *= 10;
-                if(isdigit(v.src[k])) {
-                    num += v.src[k] - '0';
-                } else {
-                    /* TODO: Numbered literals */
-                    COMP_ERR(lex->name, v.line_start, v.col_start, v.src,
-                             lex->lines.elems[v.line_start] - v.col_start,
-                             v.range, "invalid numeral");
-                    return 1;
-                }
-            }
-
-            token_t tok;
-            /* copy over fields */
-            tok.langtype = TOKL_NUM;
-            tok.toktype = TOK_NUM_INTU;
-            tok.line = v.line_start;
-            tok.col = v.col_start;
-            tok.line_end = v.line_end;
-            tok.col_end = v.col_end;
-            tok.filenam = lex->name;
-            tok.raw = v.src;
-            tok.range = v.range;
-            tok.tok_num.unsignd = num;
-            list_append(&lex->toks, tok);
-
-            continue; /* next possible token, please */
+/* Syntax type (TOKL_*) of token type `toktype`. */
+int tok_langtype(int toktype)
+{
+    switch(toktype) {
+    case TOK_NUM_INT:
+    case TOK_NUM_INTU:
+    case TOK_NUM_FLT:
+    case TOK_NUM_FLTD:
+        return TOKL_NUM;
+    case TOK_SPECIAL_STRLIT:
+        return TOKL_STRLIT;
+    case TOK_SPECIAL_LIT:
+        return TOKL_LIT;
+    default:
+        return TOKL_KEYWORD;
+    }
+}
+
+/* Lex input.
+ * Returns nonzero on failure. */
+int lex_do(lex_t *lex)
+{
+    if(!lex || !lex->buf) {
+        return 1;
+    }
+
+    token_t tok;
+    int rc;
+    /* Definitely not the reason why I decided to make
+     * a stack based lang... definitely... */
+    while((rc = lex_next(lex, &tok)) > 0) {
+        tokstore_push(&lex->toks, lex->buf, &tok);
+    }
+
+    return rc < 0;
+}
+
+/* Unpack the next lexed token into `tok`, starting from a zeroed `it`.
+ * Returns 0 once there are no tokens left. */
+int lex_iter(const lex_t *lex, tokiter_t *it, token_t *tok)
+{
+    const tokstore_t *ts = &lex->toks;
+    if(it->i >= ts->size) {
+        return 0;
+    }
+    /* payloads are in token order, so just follow along */
+    const tokpayload_t *p = NULL;
+    if(it->payload < ts->payload.size &&
+       ts->payload.elems[it->payload].tok == it->i) {
+        p = &ts->payload.elems[it->payload++];
+    }
+    lex_unpack(lex, it->i++, p, tok);
+    return 1;
+}
+
+/* Index of the first payload of token `i` or after it. */
+static size_t lex_payload_at(const lex_t *lex, size_t i)
+{
+    const tokstore_t *ts = &lex->toks;
+    /* binary search the payload */
+    size_t lo = 0, hi = ts->payload.size;
+    while(lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if(ts->payload.elems[mid].tok < i) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
         }
+    }
+    return lo;
+}
 
-        /* literal */
-        token_t tok;
-        tok.langtype = TOKL_LIT;
-        tok.toktype = TOK_SPECIAL_LIT;
-        tok.line = v.line_start;
-        tok.col = v.col_start;
-        tok.line_end = v.line_end;
-        tok.col_end = v.col_end;
-        tok.filenam = lex->name;
-        tok.raw = v.src;
-        tok.range = v.range;
-        tok.tokl_lit = tok.raw;
-        list_append(&lex->toks, tok);
+/* Unpack token `i` into `tok`. Prefer `lex_iter` for walking all of them. */
+void lex_tok(const lex_t *lex, size_t i, token_t *tok)
+{
+    const tokstore_t *ts = &lex->toks;
+    size_t at = lex_payload_at(lex, i);
+    const tokpayload_t *p = NULL;
+    if(at < ts->payload.size && ts->payload.elems[at].tok == i) {
+        p = &ts->payload.elems[at];
     }
+    lex_unpack(lex, i, p, tok);
+}
 
-    return 0;
+/* Point `it` at token `i`, so `lex_iter` goes on from there. */
+void lex_iter_at(const lex_t *lex, tokiter_t *it, size_t i)
+{
+    it->i = i;
+    it->payload = lex_payload_at(lex, i);
+}
+
+/* Source location of offset `off`. */
+srcloc_t lex_loc(lex_t *lex, size_t off)
+{
+    return srcmap_loc(&lex->lines, off);
 }
 
 /* Delete/free a lexer. */
@@ -528,16 +527,11 @@ void lex_delete(lex_t *lex)
      * "If ptr is a NULL pointer, no operation is performed." */
     free(lex->strlit);
     lex->strlit = NULL;
-    /* free all strlits */
-    for(size_t i = 0; i < lex->toks.size; i++) {
-        if(lex->toks.elems[i].langtype == TOKL_STRLIT) {
-            free((void *)lex->toks.elems[i].tokl_strlit);
-        }
-    }
-    free(lex->toks.elems);
-    lex->toks.elems = NULL;
+    /* all strlits go at once */
+    intern_free(&lex->strs);
+    tokstore_free(&lex->toks);
     free(lex->split.elems);
     lex->split.elems = NULL;
-    free(lex->lines.elems);
-    lex->lines.elems = NULL;
+    srcmap_free(&lex->lines);
+    free(lex);
 }
@@ -13,11 +13,12 @@
 
 #include "util.h"
 #include "strl.h"
+#include "srcloc.h"
+#include "intern.h"
+#include "kwlist.h"
 #include <ctype.h>
 #include <stdlib.h>
 
-#define X(x) TOK_UINT##x##_T, TOK_INT##x##_T
-
 /* Contains token types */
 enum toktype {
     TOKL_KEYWORD = 0, /* keyword */
@@ -28,48 +29,10 @@ enum toktype {
     TOK__START, /* token start */
 
     /* -- begin actual tokens --- */
-    TOK_FUNC /* func */,
-    TOK_ARROW, /* -> */
-    TOK_DO, /* do */
-    TOK_THEN, /* do but for if loops */
-    TOK_END, /* end */
-    TOK_DUP, /* dup */
-    TOK_DROP, /* drop */
-    TOK_DROPALL, /* dropall */
-    TOK_RET, /* ret */
-
-    /* -- types -- */
-    TOK_CHAR, /* char */
-    TOK_UCHAR, /* unsigned char */
-    TOK_SHORT, /* short */
-    TOK_USHORT, /* unsigned short */
-    TOK_INT, /* int */
-    TOK_UINT, /* unsigned int */
-    /* long here is 64-bit.  windows users can use WSL */
-    TOK_LONG, /* long */
-    TOK_ULONG, /* unsigned long */
-
-    TOK_STR, /* void* but fancy */
-    TOK_PTR, /* void* */
-    TOK_NONE, /* void */
-    TOK_SIZE_T, /* size_t */
-    TOK_INTMAX_T, /* intmax_t */
-    TOK_UINTMAX_T, /* uintmax_t */
-
-    /* -- *int*_t -- */
-
-    X(8),
-    X(16),
-    X(32),
-    X(64),
-
-    /* arithmetic operators */
-    TOK_ADD,
-    TOK_SUB,
-    TOK_MUL,
-    TOK_DIV,
-
-    TOK_DUMP, /* dump to stdout */
+    /* keywords, see kwlist.h */
+#define K(nam, tok) TOK_##tok,
+    KEYWORDS(K)
+#undef K
 
     /* -- number token -- */
     TOK_NUM_INT, /* int64_t  */
@@ -86,21 +49,16 @@ enum toktype {
     TOK_COUNT = (TOK__COUNTR - TOK__START) - 1, /* # of tokens */
 };
 
-#undef X
-
-/* Token. */
+/* Token, unpacked. The lexer stores tokens packed in a `tokstore_t`,
+ * see `lex_iter` to get them back out. */
 typedef struct token {
     /* langtype is syntax type (TOKL_*).
      * toktype is actual token type (TOK_*). */
     uint32_t langtype, toktype;
 
-    /* raw token text */
+    /* raw token text, `raw - lex->buf` is the source offset.
+     * Line & column come from `lex_loc` when they are needed. */
     const uint8_t *raw;
-
-    /* compiler diagnostics */
-    const char *filenam; /* file name */
-    size_t line, line_end; /* file line */
-    size_t col, col_end; /* file column */
     size_t range; /* range of raw */
 
     /* lang/toktype-specific stuff */
@@ -111,8 +69,9 @@ typedef struct token {
         const uint8_t *tokl_lit;
         /* TOKL_STRLIT : string literal */
         struct {
-            const uint8_t *tokl_strlit;
+            const uint8_t *tokl_strlit; /* decoded, NUL-terminated */
             size_t tokl_strsz;
+            uint32_t tokl_strid; /* interned string ID */
         };
         /* TOKL_NUM -- nothing */
     };
@@ -129,19 +88,52 @@ typedef struct token {
     };
 } token_t;
 
+/* Payload of a number or string literal token. */
+typedef struct tokpayload {
+    uint32_t tok; /* index of the token this belongs to */
+    union {
+        /* TOKL_NUM: same as `token_t.tok_num` */
+        union {
+            int64_t signd;
+            uint64_t unsignd;
+            float flt;
+            double fltd;
+        } num;
+        /* TOKL_STRLIT: decoded string */
+        struct {
+            const uint8_t *str;
+            size_t size;
+            uint32_t id;
+        } strlit;
+    };
+} tokpayload_t;
+
+/* Tokens, struct-of-arrays style.
+ * `type`, `start` and `len` are parallel arrays with one entry per
+ * token; that's 9 bytes a token instead of a whole `token_t`. Only
+ * numbers and string literals get an entry in `payload`, which is
+ * sorted by token index. */
+typedef struct tokstore {
+    uint8_t *type; /* TOK_* */
+    uint32_t *start; /* offset into the source */
+    uint32_t *len; /* length of the raw text */
+    size_t size, cap;
+
+    LIST(tokpayload_t) payload;
+} tokstore_t;
+
+/* Iterator over a `tokstore_t`, see `lex_iter`. */
+typedef struct tokiter {
+    size_t i; /* next token */
+    size_t payload; /* next payload */
+} tokiter_t;
+
 typedef struct view {
     /* When it starts and ends in `buf`.
      * `range` is `end` - `start`. */
     size_t start, end, range;
     /* Shorthand for `buf + start`. */
     const uint8_t *src;
-
-    /* -- file diagonstics -- */
-
-    /* start line, end line */
-    size_t line_start, line_end;
-    /* start column, end column */
-    size_t col_start, col_end;
     /* cutoff? */
     bool cutoff;
 } view_t;
@@ -156,33 +148,39 @@ typedef struct lex {
      * len -- size of `buf`. */
     size_t pos, range, len;
 
+    /* start of the lexeme `lex_next` looked at last, `len` at the end */
+    size_t last;
+
+    /* don't print diagnostics */
+    bool quiet;
+
     /* tokens that we have lexed */
-    LIST(token_t) toks;
+    tokstore_t toks;
 
     /* -- internal lexer -- */
 
-    /* Used to split the source by whitespace into a list of text */
+    /* Used to split the source by whitespace into a list of text.
+     * Only filled in when `keep_split` is set, for debugging. */
     LIST(view_t) split;
+    bool keep_split;
 
-    /* Used to determine size of lines. */
-    LIST(size_t) lines;
-
-    /* Line & column for the splitting */
-    size_t line, col;
-
-    /* Save states */
-    size_t ss_pos, ss_line, ss_col;
+    /* Line index of `buf`, for diagnostics. */
+    srcmap_t lines;
 
     /* String literal lexing.
      * Used to parse "This \"stuff\" \n" into `This "stuff" <\n>`.  */
     uint8_t *strlit;
     size_t ssize, scap; /* ssize -> string size, scap -> strlit alloc'd size */
+
+    /* Decoded string literals. Duplicates share one copy and ID. */
+    intern_t strs;
 } lex_t;
 
 /* Create a lexer. Returns NULL on failure. */
 lex_t *lex_create(void);
 
 /* Supply an input `src` with length `len` into lexer `lex`.
+ * Token offsets are 32-bit, so `len` can't be over 4 GiB.
  * Returns nonzero on failure. */
 int lex_supply_src(lex_t *lex, const uint8_t *src, size_t len);
 
@@ -190,10 +188,73 @@ int lex_supply_src(lex_t *lex, const uint8_t *src, size_t len);
  * Returns nonzero on failure. */
 int lex_supply_name(lex_t *lex, const char *name);
 
+/* Look up keyword `src` with length `len`.
+ * Returns its TOK_* type, or -1 if it is not a keyword. */
+int lex_lookup_keyword(const uint8_t *src, size_t len);
+
+/* Syntax type (TOKL_*) of token type `toktype`. */
+int tok_langtype(int toktype);
+
+/* Lex the next token of the input into `tok`.
+ * Returns 1 if a token was lexed, 0 at the end of the input,
+ * and -1 on failure. */
+int lex_next(lex_t *lex, token_t *tok);
+
 /* Lex input.
  * Returns nonzero on failure. */
 int lex_do(lex_t *lex);
 
+/* Lex input on `nthreads` threads. The tokens are exactly the ones
+ * `lex_do` would produce; small inputs are just handed to it.
+ * Returns nonzero on failure. */
+int lex_do_parallel(lex_t *lex, int nthreads);
+
+/* Re-lex `lex` after an edit: `deleted` bytes at `off` were replaced
+ * with `inserted` bytes, giving the new input `src` of length `len`
+ * (which replaces the old one). Only tokens the edit can reach are
+ * lexed again, the rest are shifted over. String IDs of untouched
+ * tokens don't change. Drops the debug view list.
+ * Returns nonzero on failure, leaving the tokens and input as they were
+ * (`src` doesn't lex, or the edit doesn't fit the old input). */
+int lex_edit(lex_t *lex, const uint8_t *src, size_t len, size_t off,
+             size_t deleted, size_t inserted);
+
+/* Make room for `n` tokens in `ts`. */
+void tokstore_reserve(tokstore_t *ts, size_t n);
+
+/* Append token `tok` to `ts`, `base` being the start of the source. */
+void tokstore_push(tokstore_t *ts, const uint8_t *base, const token_t *tok);
+
+/* Free the tokens in `ts`. */
+void tokstore_free(tokstore_t *ts);
+
+/* Unpack the next lexed token into `tok`, starting from a zeroed `it`.
+ * Returns 0 once there are no tokens left. */
+int lex_iter(const lex_t *lex, tokiter_t *it, token_t *tok);
+
+/* Unpack token `i` into `tok`. Prefer `lex_iter` for walking all of them. */
+void lex_tok(const lex_t *lex, size_t i, token_t *tok);
+
+/* Point `it` at token `i`, so `lex_iter` goes on from there. */
+void lex_iter_at(const lex_t *lex, tokiter_t *it, size_t i);
+
+/* Source location of offset `off`. */
+srcloc_t lex_loc(lex_t *lex, size_t off);
+
+/* Print a diagnostic for `hl` bytes at offset `off` in the input. */
+#define LEX_DIAG(label, lex, off, hl, ...)                                 \
+    do {                                                                   \
+        if(!(lex)->quiet) {                                                \
+            SRC_DIAG(label, (lex)->name, &(lex)->lines, off, hl,           \
+                     __VA_ARGS__);                                         \
+        }                                                                  \
+    } while(0);
+
+#define LEX_ERR(lex, off, hl, ...) LEX_DIAG("error", lex, off, hl, __VA_ARGS__)
+
+#define LEX_WARN(lex, off, hl, ...) \
+    LEX_DIAG("warning", lex, off, hl, __VA_ARGS__)
+
 /* Delete/free a lexer. */
 void lex_delete(lex_t *lex);
 
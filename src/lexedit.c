@@ -0,0 +1,175 @@
+/*
+ * Copyright (C) 2025 therealblue24.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Incremental re-lexing.
+ *
+ * Lexing only depends on where a lexeme starts. So after an edit, lexing
+ * starts again at the last token that ends before the edit, and stops as
+ * soon as a token starts where an old token after the edit started (give
+ * or take the size change). Everything from there on is the same as
+ * before, just shifted. An edit that opens a comment or string literal
+ * simply doesn't meet an old token start until the comment or literal
+ * ends, so the re-lexed region grows as far as it has to.
+ */
+#include "lex.h"
+
+/* Number of tokens in `ts` starting before `off`. */
+static size_t tokstore_lower(const tokstore_t *ts, size_t off)
+{
+    size_t lo = 0, hi = ts->size;
+    while(lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if(ts->start[mid] < off) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/* Index of the first payload of `ts` belonging to token `i` or later. */
+static size_t payload_lower(const tokstore_t *ts, size_t i)
+{
+    size_t lo = 0, hi = ts->payload.size;
+    while(lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if(ts->payload.elems[mid].tok < i) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/* Replace tokens `keep..tail` of `ts` with `mid`, and shift the
+ * tokens after that by `delta` bytes. */
+static void tokstore_splice(tokstore_t *ts, size_t keep, size_t tail,
+                            const tokstore_t *mid, ptrdiff_t delta)
+{
+    size_t ntail = ts->size - tail;
+    size_t at = keep + mid->size; /* where the tail goes */
+
+    /* most edits don't change the token count, the tail stays put */
+    if(at != tail) {
+        tokstore_reserve(ts, at + ntail);
+        memmove(ts->type + at, ts->type + tail, ntail * sizeof(*ts->type));
+        memmove(ts->start + at, ts->start + tail,
+                ntail * sizeof(*ts->start));
+        memmove(ts->len + at, ts->len + tail, ntail * sizeof(*ts->len));
+    }
+    if(delta != 0) {
+        uint32_t *start = ts->start + at;
+        for(size_t i = 0; i < ntail; i++) {
+            start[i] += (uint32_t)delta; /* wraps around for negatives */
+        }
+    }
+    memcpy(ts->type + keep, mid->type, mid->size * sizeof(*ts->type));
+    memcpy(ts->start + keep, mid->start, mid->size * sizeof(*ts->start));
+    memcpy(ts->len + keep, mid->len, mid->size * sizeof(*ts->len));
+    ts->size = at + ntail;
+
+    /* same again for the payloads, which point at tokens by index */
+    size_t pkeep = payload_lower(ts, keep);
+    size_t ptail = payload_lower(ts, tail);
+    size_t pntail = ts->payload.size - ptail;
+    size_t pat = pkeep + mid->payload.size;
+
+    list_resize(&ts->payload, pat + pntail);
+    tokpayload_t *p = ts->payload.elems;
+    if(pat != ptail) {
+        memmove(p + pat, p + ptail, pntail * sizeof(*p));
+    }
+    if(at != tail) {
+        for(size_t i = pat; i < pat + pntail; i++) {
+            p[i].tok = (uint32_t)(p[i].tok - tail + at);
+        }
+    }
+    for(size_t i = 0; i < mid->payload.size; i++) {
+        p[pkeep + i] = mid->payload.elems[i];
+        p[pkeep + i].tok += (uint32_t)keep;
+    }
+    ts->payload.size = pat + pntail;
+}
+
+/* Re-lex `lex` after `deleted` bytes at `off` were replaced with
+ * `inserted` bytes, `src` being the edited input.
+ * Returns nonzero on failure. */
+int lex_edit(lex_t *lex, const uint8_t *src, size_t len, size_t off,
+             size_t deleted, size_t inserted)
+{
+    if(!lex || !lex->buf || !src) {
+        return 1;
+    }
+    if(off > lex->len || deleted > lex->len - off ||
+       len != lex->len - deleted + inserted || len > UINT32_MAX) {
+        return 1;
+    }
+
+    tokstore_t *ts = &lex->toks;
+
+    /* The last token ending before `off` can't have changed, and nor
+     * can anything before it: restart right at it. Tokens butting up
+     * against the edit might grow, so those go again too. */
+    size_t keep = tokstore_lower(ts, off);
+    while(keep > 0 && ts->start[keep - 1] + ts->len[keep - 1] >= off) {
+        keep--;
+    }
+    size_t restart = keep > 0 ? ts->start[--keep] : 0;
+
+    /* old tokens that could line up again */
+    size_t tail = tokstore_lower(ts, off + deleted);
+
+    /* put back if the edited input doesn't lex */
+    const uint8_t *obuf = lex->buf;
+    size_t olen = lex->len, opos = lex->pos;
+
+    lex->buf = src;
+    lex->len = len;
+    lex->pos = restart;
+    srcmap_init(&lex->lines, src, len);
+    lex->split.size = 0;
+
+    tokstore_t mid = { 0 };
+    token_t tok;
+    int rc;
+    while((rc = lex_next(lex, &tok)) > 0) {
+        size_t s = lex->last;
+        if(s >= off + inserted) {
+            /* same spot in the old input */
+            size_t o = s - inserted + deleted;
+            while(tail < ts->size && ts->start[tail] < o) {
+                tail++;
+            }
+            if(tail < ts->size && ts->start[tail] == o) {
+                break;
+            }
+        }
+        tokstore_push(&mid, src, &tok);
+    }
+    if(rc < 0) {
+        /* the tokens are the old input's, leave them be */
+        tokstore_free(&mid);
+        lex->buf = obuf;
+        lex->len = olen;
+        lex->pos = opos;
+        srcmap_init(&lex->lines, obuf, olen);
+        return 1;
+    }
+    if(rc == 0) {
+        /* ran to the end, no old tokens left */
+        tail = ts->size;
+    }
+
+    tokstore_splice(ts, keep, tail, &mid,
+                    (ptrdiff_t)inserted - (ptrdiff_t)deleted);
+    tokstore_free(&mid);
+    lex->pos = len;
+
+    return 0;
+}
@@ -0,0 +1,260 @@
+/*
+ * Copyright (C) 2025 therealblue24.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Parallel lexing.
+ *
+ * The input is cut into chunks at newlines. Every chunk is lexed on its
+ * own, guessing that its first newline is not inside a block comment or
+ * string literal. The guess is checked while stitching the chunks back
+ * together in order: lexing only depends on where a lexeme starts, so as
+ * soon as the previous (known good) chunk and this one agree on a token
+ * start, everything after it agrees too. When they never agree, that
+ * part is simply lexed again on the calling thread.
+ */
+#include "lex.h"
+#include "scan.h"
+#include <pthread.h>
+#include <stdatomic.h>
+
+/* don't bother with threads below this */
+#define CHUNK_MIN (256 * 1024)
+/* chunks per thread, for load balancing */
+#define CHUNKS_PER_THREAD 4
+
+/* One chunk of the input. */
+struct chunk {
+    lex_t *lex; /* chunk lexer, quiet */
+    size_t start; /* where lexing starts (a guess, except chunk 0) */
+    size_t next; /* `start` of the next chunk, or the input length */
+    /* first token start at or past `next` (or the input length): where
+     * the next chunk has to pick up */
+    size_t sync;
+    /* lexing failed at lexeme `err_at`, tokens before it are fine */
+    bool err;
+    size_t err_at;
+};
+
+struct pool {
+    struct chunk *chunks;
+    size_t nchunks;
+    atomic_size_t taken; /* next chunk to hand out */
+};
+
+/* Lex chunk `c`, keeping the tokens that start before `c->next`. */
+static void chunk_lex(struct chunk *c)
+{
+    lex_t *lex = c->lex;
+    lex->pos = c->start;
+    c->sync = lex->len;
+    c->err = false;
+
+    token_t tok;
+    int rc;
+    while((rc = lex_next(lex, &tok)) > 0) {
+        if(lex->last >= c->next) {
+            c->sync = lex->last;
+            return;
+        }
+        tokstore_push(&lex->toks, lex->buf, &tok);
+    }
+    if(rc < 0) {
+        /* past the end of the chunk it's the next chunk's problem */
+        if(lex->last >= c->next) {
+            c->sync = lex->last;
+        } else {
+            c->err = true;
+            c->err_at = lex->last;
+        }
+    }
+}
+
+static void *worker(void *arg)
+{
+    struct pool *pool = arg;
+    size_t i;
+    while((i = atomic_fetch_add(&pool->taken, 1)) < pool->nchunks) {
+        chunk_lex(&pool->chunks[i]);
+    }
+    return NULL;
+}
+
+/* Index of the token of `c` starting at `off`, or -1. */
+static ptrdiff_t chunk_find(const struct chunk *c, size_t off)
+{
+    const tokstore_t *ts = &c->lex->toks;
+    size_t lo = 0, hi = ts->size;
+    while(lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if(ts->start[mid] < off) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo < ts->size && ts->start[lo] == off ? (ptrdiff_t)lo : -1;
+}
+
+/* Append tokens `from..` of chunk `c` to `lex`. */
+static void chunk_take(lex_t *lex, const struct chunk *c, size_t from)
+{
+    const lex_t *cl = c->lex;
+    const tokstore_t *ts = &cl->toks;
+    tokiter_t it = { 0 };
+    token_t tok;
+
+    /* skip to `from`, payloads included */
+    while(it.payload < ts->payload.size &&
+          ts->payload.elems[it.payload].tok < from) {
+        it.payload++;
+    }
+    it.i = from;
+
+    while(lex_iter(cl, &it, &tok)) {
+        /* re-intern in token order, so IDs come out like `lex_do`'s */
+        if(tok.langtype == TOKL_STRLIT) {
+            tok.tokl_strid =
+                intern_put(&lex->strs, tok.tokl_strlit, tok.tokl_strsz);
+            tok.tokl_strlit = intern_get(&lex->strs, tok.tokl_strid).str;
+        }
+        tokstore_push(&lex->toks, lex->buf, &tok);
+    }
+}
+
+/* Chunk holding the token starting at `off`, and the token index in
+ * `*at`. Returns -1 if no chunk has a token there. */
+static ptrdiff_t chunks_find(const struct chunk *chunks, size_t nchunks,
+                             size_t from, size_t off, size_t *at)
+{
+    for(size_t k = from; k < nchunks && chunks[k].start <= off; k++) {
+        if(off >= chunks[k].next) {
+            continue;
+        }
+        ptrdiff_t i = chunk_find(&chunks[k], off);
+        if(i < 0) {
+            return -1;
+        }
+        *at = (size_t)i;
+        return (ptrdiff_t)k;
+    }
+    return -1;
+}
+
+/* Stitch the chunks together into `lex`.
+ * Returns nonzero on failure. */
+static int chunks_merge(lex_t *lex, struct chunk *chunks, size_t nchunks)
+{
+    size_t k = 0, at = 0; /* chunk 0 starts at 0, so it's right */
+    token_t tok;
+
+    for(;;) {
+        /* -- trusted chunk mode: chunk `k` from token `at` -- */
+        struct chunk *c = &chunks[k];
+        chunk_take(lex, c, at);
+
+        size_t resume;
+        if(c->err) {
+            /* redo it here so it gets reported */
+            resume = c->err_at;
+        } else if(c->sync >= lex->len) {
+            return 0;
+        } else {
+            ptrdiff_t nk =
+                chunks_find(chunks, nchunks, k + 1, c->sync, &at);
+            if(nk >= 0) {
+                k = (size_t)nk;
+                continue;
+            }
+            resume = c->sync;
+        }
+
+        /* -- bad guess: lex here until a chunk agrees with us again -- */
+        lex->pos = resume;
+        for(;;) {
+            int rc = lex_next(lex, &tok);
+            if(rc < 0) {
+                return 1;
+            }
+            if(rc == 0) {
+                return 0;
+            }
+            ptrdiff_t nk = chunks_find(chunks, nchunks, k, lex->last, &at);
+            if(nk >= 0) {
+                k = (size_t)nk;
+                break;
+            }
+            tokstore_push(&lex->toks, lex->buf, &tok);
+        }
+    }
+}
+
+/* Lex input on `nthreads` threads. The tokens are exactly the ones
+ * `lex_do` would produce; small inputs are just handed to it.
+ * Returns nonzero on failure. */
+int lex_do_parallel(lex_t *lex, int nthreads)
+{
+    if(!lex || !lex->buf) {
+        return 1;
+    }
+
+    /* the debug view list only comes out of a serial run */
+    if(nthreads <= 1 || lex->keep_split || lex->len < 2 * CHUNK_MIN) {
+        return lex_do(lex);
+    }
+
+    size_t want = (size_t)nthreads * CHUNKS_PER_THREAD;
+    size_t size = size_max(CHUNK_MIN, lex->len / want);
+
+    /* chunk starts: right after the first newline past each cut */
+    LIST(struct chunk) chunks = { 0 };
+    size_t start = 0;
+    while(start < lex->len) {
+        struct chunk c = { 0 };
+        c.start = start;
+        size_t cut = start + size;
+        size_t nl = cut < lex->len ? scan_newline(lex->buf, cut, lex->len)
+                                   : lex->len;
+        start = nl < lex->len ? nl + 1 : lex->len;
+        c.next = start;
+        list_append(&chunks, c);
+    }
+
+    for(size_t i = 0; i < chunks.size; i++) {
+        lex_t *cl = lex_create();
+        lex_supply_src(cl, lex->buf, lex->len);
+        lex_supply_name(cl, lex->name ? lex->name : "<unknown>");
+        cl->quiet = true;
+        chunks.elems[i].lex = cl;
+    }
+
+    struct pool pool;
+    pool.chunks = chunks.elems;
+    pool.nchunks = chunks.size;
+    atomic_init(&pool.taken, 0);
+
+    /* this thread works too */
+    size_t nworkers = (size_t)nthreads - 1;
+    pthread_t *threads = zcalloc(nworkers, sizeof(*threads));
+    size_t started = 0;
+    for(; started < nworkers; started++) {
+        if(pthread_create(&threads[started], NULL, worker, &pool)) {
+            break; /* fine, fewer threads */
+        }
+    }
+    worker(&pool);
+    for(size_t i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    free(threads);
+
+    int rc = chunks_merge(lex, chunks.elems, chunks.size);
+
+    for(size_t i = 0; i < chunks.size; i++) {
+        lex_delete(chunks.elems[i].lex);
+    }
+    free(chunks.elems);
+    return rc;
+}
@@ -10,7 +10,13 @@
 
 #include "lex.h"
 #include "cg.h"
+#include "input.h"
+#include "opt.h"
+#include "jit.h"
+#include "vm.h"
+#include <inttypes.h>
 #include <stdio.h>
+#include <time.h>
 
 static void bar(void)
 {
@@ -25,10 +31,11 @@ static void named_bar(const char *l)
     bar();
 }
 
-static void print_el(const char *src, view_t v)
+static void print_el(lex_t *l, view_t v)
 {
-    printf("%s:%zu:%zu: \"%.*s\" ", src, v.line_start, v.col_start,
-           (int)v.range, v.src);
+    srcloc_t loc = lex_loc(l, v.start);
+    printf("%s:%zu:%zu: \"%.*s\" ", l->name, loc.line, loc.col, (int)v.range,
+           v.src);
     if(v.cutoff) {
         printf("(cutoff)");
     }
@@ -36,47 +43,189 @@ static void print_el(const char *src, view_t v)
     return;
 }
 
-int main(int argc, char *argv[])
+static void print_num(token_t tok)
+{
+    switch(tok.toktype) {
+    case TOK_NUM_INT:
+        printf("(num) %" PRId64 "\n", tok.tok_num.signd);
+        break;
+    case TOK_NUM_INTU:
+        printf("(num) %" PRIu64 "\n", tok.tok_num.unsignd);
+        break;
+    case TOK_NUM_FLT:
+        printf("(num) %gf\n", (double)tok.tok_num.flt);
+        break;
+    case TOK_NUM_FLTD:
+        printf("(num) %g\n", tok.tok_num.fltd);
+        break;
+    }
+    return;
+}
+
+/* Monotonic time in microseconds. */
+static double now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e6 + (double)ts.tv_nsec * 1e-3;
+}
+
+/* --run: compile `ir` to memory and run it, its `ret` is the exit code */
+static int run(const char *argv0, const ir_t *ir, lex_t *l, bool stats)
+{
+    double t = now_us();
+    jit_t j;
+    if(jit_compile(&j, ir, l)) {
+        fprintf(stderr, "%s: failed to compile\n", argv0);
+        return 1;
+    }
+    if(stats) {
+        fprintf(stderr, "jit: %zu bytes mapped in %.1f us\n", j.size,
+                now_us() - t);
+    }
+    int64_t r = jit_run(&j);
+    /* the program's printf and ours share stdout */
+    fflush(stdout);
+    jit_free(&j);
+    return (int)r;
+}
+
+/* --vm: compile the tokens of `l` to bytecode and interpret them */
+static int interp(const char *argv0, lex_t *l, bool checked, bool stats)
 {
-    (void)argc;
-    FILE *in = fopen(argv[1], "rb");
+    vmprog_t p;
+    if(vm_compile(&p, l, true)) {
+        fprintf(stderr, "%s: failed to compile\n", argv0);
+        return 1;
+    }
+    if(stats) {
+        fprintf(stderr, "vm: %zu words, %" PRIu32 " deep, %s\n", p.code.size,
+                p.maxdepth, checked ? "checked" : "unchecked");
+        fuse_stats(&p.fused, "vm", stderr);
+    }
+    int64_t r;
+    if(vm_run(&p, l, checked, &r)) {
+        r = 1;
+    }
+    fflush(stdout);
+    vm_free(&p);
+    return (int)r;
+}
 
-    /* slurp file */
+int main(int argc, char *argv[])
+{
+    /* no file means stdin, same as "-" */
+    const char *path = "-";
+    bool stats = false; /* --stats */
+    bool dump_ir = false; /* --ir */
+    int jobs = 1; /* -j N, lexer threads */
+    int olevel = 0; /* -O[N] */
+    bool x64 = false; /* --backend x64 */
+    bool jit = false; /* --run */
+    bool vm = false; /* --vm */
+    bool checked = true; /* not --unchecked */
 
-    size_t size = 0;
-    fseek(in, 0, SEEK_END);
-    size = (size_t)ftell(in);
-    rewind(in);
-    uint8_t *mem = calloc(1, size);
+    for(int i = 1; i < argc; i++) {
+        if(strcmp(argv[i], "--stats") == 0) {
+            stats = true;
+        } else if(strcmp(argv[i], "--run") == 0) {
+            jit = true;
+        } else if(strcmp(argv[i], "--vm") == 0) {
+            vm = true;
+        } else if(strcmp(argv[i], "--unchecked") == 0) {
+            checked = false;
+        } else if(strcmp(argv[i], "--ir") == 0) {
+            dump_ir = true;
+        } else if(strncmp(argv[i], "-O", 2) == 0) {
+            /* plain -O is -O1 */
+            olevel = argv[i][2] ? atoi(argv[i] + 2) : 1;
+        } else if(strcmp(argv[i], "--backend") == 0 && i + 1 < argc) {
+            const char *be = argv[++i];
+            if(strcmp(be, "x64") == 0) {
+                x64 = true;
+            } else if(strcmp(be, "qbe") != 0) {
+                fprintf(stderr, "%s: unknown backend `%s`\n", argv[0], be);
+                return 1;
+            }
+        } else if(strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            jobs = atoi(argv[++i]);
+        } else {
+            path = argv[i];
+        }
+    }
 
-    fread(mem, 1, size, in);
-    fclose(in);
+    input_t in;
+    if(input_open(&in, path)) {
+        fprintf(stderr, "%s: %s: %s\n", argv[0], path, strerror(errno));
+        return 1;
+    }
 
+    /* tokens point straight into `in.buf`, no copies */
     lex_t *l = lex_create();
-    lex_supply_src(l, mem, size);
-    lex_supply_name(l, argv[1]);
+    lex_supply_src(l, in.buf, in.len);
+    lex_supply_name(l, in.name);
+    /* only the dump below looks at the split list, and keeping it
+     * needs a serial run */
+    bool dump = !vm && !jit;
+    l->keep_split = dump && jobs <= 1;
 
-    if(lex_do(l)) {
+    if(lex_do_parallel(l, jobs)) {
         fprintf(stderr, "%s: failed to compile\n", argv[0]);
         lex_delete(l);
-        free(mem);
+        input_close(&in);
         return 1;
     }
 
+    if(stats) {
+        intern_stats(&l->strs, stderr);
+    }
+
+    /* no dumps, no files: straight from the tokens to running code */
+    if(vm) {
+        int r = interp(argv[0], l, checked, stats);
+        lex_delete(l);
+        input_close(&in);
+        return r;
+    }
+    if(jit) {
+        ir_t ir;
+        int r = 1;
+        if(ir_build(&ir, l) == 0) {
+            optstats_t ost;
+            opt_run(&ir, olevel, &ost);
+            if(stats) {
+                fuse_stats(&ir.fused, "ir", stderr);
+                opt_stats(&ost, stderr);
+            }
+            r = run(argv[0], &ir, l, stats);
+        } else {
+            fprintf(stderr, "%s: failed to compile\n", argv[0]);
+        }
+        ir_free(&ir);
+        lex_delete(l);
+        input_close(&in);
+        return r;
+    }
+
     named_bar("Lexing pt. 1");
 
+    if(!l->keep_split) {
+        printf("(not kept with -j %d, run without -j to see it)\n", jobs);
+    }
     for(size_t i = 0; i < l->split.size; i++) {
-        print_el(argv[1], l->split.elems[i]);
+        print_el(l, l->split.elems[i]);
     }
 
     named_bar("Lexing pt. 2");
 
-    for(size_t i = 0; i < l->toks.size; i++) {
-        token_t tok = l->toks.elems[i];
-        printf("%s:%zu:%zu: ", tok.filenam, tok.line, tok.col);
+    tokiter_t iter = { 0 };
+    token_t tok;
+    while(lex_iter(l, &iter, &tok)) {
+        srcloc_t loc = lex_loc(l, (size_t)(tok.raw - l->buf));
+        printf("%s:%zu:%zu: ", l->name, loc.line, loc.col);
         switch(tok.langtype) {
         case TOKL_NUM:
-            printf("(num) %llu\n", tok.tok_num.unsignd);
+            print_num(tok);
             break;
         case TOKL_STRLIT:
             printf("(strlit) `%s`\n", tok.tokl_strlit);
@@ -90,12 +239,49 @@ int main(int argc, char *argv[])
         }
     }
 
-    FILE *f = fopen("out.ssa", "w");
-    cg_emit(l, f);
+    ir_t ir;
+    if(ir_build(&ir, l)) {
+        fprintf(stderr, "%s: failed to compile\n", argv[0]);
+        ir_free(&ir);
+        lex_delete(l);
+        input_close(&in);
+        return 1;
+    }
+
+    optstats_t ost;
+    opt_run(&ir, olevel, &ost);
+    if(stats) {
+        fuse_stats(&ir.fused, "ir", stderr);
+        opt_stats(&ost, stderr);
+    }
+
+    if(dump_ir) {
+        named_bar("IR");
+        ir_dump(&ir, stdout);
+    }
 
-    fclose(f);
+    /* QBE text, or assembly for cc */
+    const char *outname = x64 ? "out.s" : "out.ssa";
+    emit_t out;
+    if(emit_open(&out, outname)) {
+        fprintf(stderr, "%s: %s: %s\n", argv[0], outname, strerror(errno));
+        ir_free(&ir);
+        lex_delete(l);
+        input_close(&in);
+        return 1;
+    }
+    if(x64) {
+        cg_x64(&ir, &out);
+    } else {
+        cg_qbe(&ir, &out);
+    }
+    if(emit_close(&out)) {
+        fprintf(stderr, "%s: %s: %s\n", argv[0], outname, strerror(errno));
+    }
 
-    free(mem);
+    ir_free(&ir);
+    lex_delete(l);
+    input_close(&in);
 
     return 0;
 }
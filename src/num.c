@@ -0,0 +1,298 @@
+/*
+ * Copyright (C) 2025 therealblue24.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Numeric literal parsing.
+ */
+#include "num.h"
+#include "lex.h"
+
+/* SWAR only works when the first byte in memory is the low one */
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define NUM_SWAR 1
+#else
+#define NUM_SWAR 0
+#endif
+
+static int isdigitb(int c)
+{
+    return (unsigned)(c - '0') < 10;
+}
+
+/* Value of digit `c` in any base up to 16, or 16 if it isn't one. */
+static unsigned digitval(int c)
+{
+    if(isdigitb(c)) {
+        return (unsigned)(c - '0');
+    }
+    c |= 0x20; /* lowercase */
+    if(c >= 'a' && c <= 'f') {
+        return (unsigned)(c - 'a' + 10);
+    }
+    return 16;
+}
+
+#if NUM_SWAR
+/* Are all 8 bytes of `v` ASCII digits? */
+static inline bool swar_is8digits(uint64_t v)
+{
+    return ((v & 0xf0f0f0f0f0f0f0f0ull) |
+            (((v + 0x0606060606060606ull) & 0xf0f0f0f0f0f0f0f0ull) >> 4)) ==
+           0x3333333333333333ull;
+}
+
+/* Convert 8 ASCII digits in `v` to their value, in three multiplies. */
+static inline uint32_t swar_parse8(uint64_t v)
+{
+    const uint64_t mask = 0x000000ff000000ffull;
+    const uint64_t mul1 = 100 + (1000000ull << 32);
+    const uint64_t mul2 = 1 + (10000ull << 32);
+    v -= 0x3030303030303030ull;
+    v = (v * 10) + (v >> 8); /* pairs */
+    v = (((v & mask) * mul1) + (((v >> 16) & mask) * mul2)) >> 32;
+    return (uint32_t)v;
+}
+#endif
+
+/* Accumulate the digits in `src[*i..len)` in `base` into `*acc`,
+ * allowing single `_` between digits. Stops at the first byte that
+ * isn't part of the number. Returns the number of digits read, or
+ * (size_t)-1 on a misplaced `_`. Sets `*ovf` on overflow. */
+static size_t num_digits(const uint8_t *src, size_t len, size_t *i,
+                         unsigned base, uint64_t *acc, bool *ovf)
+{
+    size_t ndigits = 0;
+    size_t p = *i;
+    uint64_t a = *acc;
+
+    while(p < len) {
+#if NUM_SWAR
+        /* decimal fast path, eight digits per step */
+        if(base == 10 && p + 8 <= len) {
+            uint64_t w;
+            memcpy(&w, src + p, 8);
+            if(swar_is8digits(w)) {
+                uint64_t hi;
+                if(__builtin_mul_overflow(a, 100000000ull, &hi) ||
+                   __builtin_add_overflow(hi, swar_parse8(w), &a)) {
+                    *ovf = true;
+                }
+                p += 8;
+                ndigits += 8;
+                continue;
+            }
+        }
+#endif
+        int c = src[p];
+        if(c == '_') {
+            /* only between two digits */
+            if(ndigits == 0 || p + 1 >= len ||
+               digitval(src[p + 1]) >= base) {
+                return (size_t)-1;
+            }
+            p++;
+            continue;
+        }
+        unsigned d = digitval(c);
+        if(d >= base) {
+            break;
+        }
+        if(__builtin_mul_overflow(a, (uint64_t)base, &a) ||
+           __builtin_add_overflow(a, (uint64_t)d, &a)) {
+            *ovf = true;
+        }
+        p++;
+        ndigits++;
+    }
+
+    *i = p;
+    *acc = a;
+    return ndigits;
+}
+
+/* exactly representable powers of ten */
+static const double pow10tab[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+static const float pow10tabf[] = {
+    1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f,
+};
+
+/* Slow path: let libc round it, without the `_`s. */
+static int num_float_slow(const uint8_t *src, size_t len, bool single,
+                          num_t *out)
+{
+    char stackbuf[128];
+    char *buf = len < sizeof(stackbuf) ? stackbuf : zalloc(len + 1);
+    size_t n = 0;
+    for(size_t i = 0; i < len; i++) {
+        if(src[i] != '_') {
+            buf[n++] = (char)src[i];
+        }
+    }
+    buf[n] = 0;
+
+    errno = 0;
+    if(single) {
+        out->flt = strtof(buf, NULL);
+    } else {
+        out->fltd = strtod(buf, NULL);
+    }
+    int rc = errno == ERANGE ? NUM_ERANGE : NUM_OK;
+    if(buf != stackbuf) {
+        free(buf);
+    }
+    return rc;
+}
+
+/* Parse a decimal float, `src[0..len)` without sign or suffix. */
+static int num_float(const uint8_t *src, size_t len, bool neg, bool single,
+                     num_t *out)
+{
+    size_t i = 0;
+    uint64_t mant = 0;
+    bool ovf = false;
+    int64_t exp10 = 0;
+
+    size_t nint = num_digits(src, len, &i, 10, &mant, &ovf);
+    if(nint == (size_t)-1) {
+        return NUM_EINVAL;
+    }
+    size_t nfrac = 0;
+    if(i < len && src[i] == '.') {
+        i++;
+        nfrac = num_digits(src, len, &i, 10, &mant, &ovf);
+        if(nfrac == (size_t)-1) {
+            return NUM_EINVAL;
+        }
+        exp10 -= (int64_t)nfrac;
+    }
+    if(nint + nfrac == 0) {
+        return NUM_EINVAL;
+    }
+    if(i < len && (src[i] | 0x20) == 'e') {
+        i++;
+        bool eneg = false;
+        if(i < len && (src[i] == '-' || src[i] == '+')) {
+            eneg = src[i++] == '-';
+        }
+        uint64_t e = 0;
+        bool eovf = false;
+        size_t ne = num_digits(src, len, &i, 10, &e, &eovf);
+        if(ne == 0 || ne == (size_t)-1) {
+            return NUM_EINVAL;
+        }
+        if(eovf || e > 100000) {
+            e = 100000; /* way out of range either way */
+        }
+        exp10 += eneg ? -(int64_t)e : (int64_t)e;
+    }
+    if(i != len) {
+        return NUM_EINVAL;
+    }
+
+    out->toktype = single ? TOK_NUM_FLT : TOK_NUM_FLTD;
+
+    /* Clinger's fast path: when the mantissa and the power of ten are
+     * both exact, one IEEE multiply or divide is correctly rounded. */
+    if(!ovf && !single && mant <= (1ull << 53) && exp10 >= -22 &&
+       exp10 <= 22) {
+        double d = (double)mant;
+        d = exp10 < 0 ? d / pow10tab[-exp10] : d * pow10tab[exp10];
+        out->fltd = neg ? -d : d;
+        return NUM_OK;
+    }
+    if(!ovf && single && mant <= (1ull << 24) && exp10 >= -10 &&
+       exp10 <= 10) {
+        float f = (float)mant;
+        f = exp10 < 0 ? f / pow10tabf[-exp10] : f * pow10tabf[exp10];
+        out->flt = neg ? -f : f;
+        return NUM_OK;
+    }
+
+    int rc = num_float_slow(src, len, single, out);
+    if(neg) {
+        if(single) {
+            out->flt = -out->flt;
+        } else {
+            out->fltd = -out->fltd;
+        }
+    }
+    return rc;
+}
+
+/* Parse the numeral `src` with length `len` into `out`.
+ *
+ * Integers are decimal, or hex/binary/octal with a 0x/0b/0o prefix,
+ * and can have `_` between digits. Floats are decimal with a fraction
+ * and/or exponent, optionally followed by `f` for single precision.
+ * A leading `-` negates.
+ *
+ * Returns NUM_OK, or NUM_EINVAL/NUM_ERANGE on failure. */
+int num_parse(const uint8_t *src, size_t len, num_t *out)
+{
+    bool neg = false;
+    if(len && src[0] == '-') {
+        neg = true;
+        src++;
+        len--;
+    }
+    if(len == 0 || !isdigitb(src[0])) {
+        return NUM_EINVAL;
+    }
+
+    /* prefixed integer? */
+    unsigned base = 10;
+    size_t i = 0;
+    if(len > 2 && src[0] == '0') {
+        switch(src[1] | 0x20) {
+        case 'x':
+            base = 16;
+            break;
+        case 'b':
+            base = 2;
+            break;
+        case 'o':
+            base = 8;
+            break;
+        }
+        i = base == 10 ? 0 : 2;
+    }
+
+    uint64_t val = 0;
+    bool ovf = false;
+    size_t nd = num_digits(src, len, &i, base, &val, &ovf);
+    if(nd == (size_t)-1 || nd == 0) {
+        return NUM_EINVAL;
+    }
+
+    if(i != len) {
+        /* only decimals have a float form */
+        if(base != 10) {
+            return NUM_EINVAL;
+        }
+        bool single = (src[len - 1] | 0x20) == 'f';
+        return num_float(src, len - single, neg, single, out);
+    }
+
+    if(ovf) {
+        return NUM_ERANGE;
+    }
+    if(neg) {
+        /* -2^63 is the furthest we can go */
+        if(val > (uint64_t)INT64_MAX + 1) {
+            return NUM_ERANGE;
+        }
+        out->toktype = TOK_NUM_INT;
+        out->signd = (int64_t)(0 - val);
+        return NUM_OK;
+    }
+    out->toktype = TOK_NUM_INTU;
+    out->unsignd = val;
+    return NUM_OK;
+}
@@ -0,0 +1,45 @@
+/*
+ * Copyright (C) 2025 therealblue24.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Header file for numeric literal parsing.
+ */
+#ifndef NUM_H_
+#define NUM_H_
+
+#include "util.h"
+
+/* num_parse() results */
+enum {
+    NUM_OK = 0,
+    NUM_EINVAL, /* not a valid numeral */
+    NUM_ERANGE, /* doesn't fit */
+};
+
+/* A parsed number. */
+typedef struct num {
+    /* TOK_NUM_INT for negative integers, TOK_NUM_INTU for the rest,
+     * TOK_NUM_FLTD for floats, TOK_NUM_FLT with an `f` suffix. */
+    int toktype;
+    union {
+        int64_t signd;
+        uint64_t unsignd;
+        float flt;
+        double fltd;
+    };
+} num_t;
+
+/* Parse the numeral `src` with length `len` into `out`.
+ *
+ * Integers are decimal, or hex/binary/octal with a 0x/0b/0o prefix,
+ * and can have `_` between digits. Floats are decimal with a fraction
+ * and/or exponent, optionally followed by `f` for single precision.
+ * A leading `-` negates.
+ *
+ * Returns NUM_OK, or NUM_EINVAL/NUM_ERANGE on failure. */
+int num_parse(const uint8_t *src, size_t len, num_t *out);
+
+#endif /* NUM_H_ */
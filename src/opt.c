@@ -0,0 +1,622 @@
+/*
+ * Copyright (C) 2025 therealblue24.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * IR optimizer: inlining, constant folding and stack-effect peephole.
+ *
+ * Small functions go inline first: a leaf without control flow is
+ * copied in place of every call to it, so its body folds with the
+ * caller's.
+ *
+ * Values are tracked symbolically. Constants stay symbolic (and fold)
+ * until something needs them in a register, and then go into one in
+ * the block that needs it, so they never have to flow through phis.
+ * Whatever is pushed but never used just never shows up, and branches
+ * on constants become jumps. What no longer runs then goes (see
+ * `ir_prune`), and a liveness pass deletes arithmetic (and phis)
+ * nobody reads.
+ */
+#include "opt.h"
+
+/* Biggest function that goes inline, in ops that turn into code, by
+ * level. */
+static const size_t inline_max[OPT_MAX + 1] = { 0, 8, 32 };
+
+/* Symbolic value of a vreg. */
+struct sval {
+    bool cnst; /* constant `imm` */
+    uint32_t reg; /* register holding it, IR_NOREG if none yet */
+    uint32_t blk; /* constants: block `reg` was set in */
+    int64_t imm;
+};
+
+/* Optimizer state. */
+struct opt {
+    ir_t *ir;
+    irins_t *out; /* new ops */
+    size_t size;
+    struct sval *val; /* per vreg */
+    uint32_t *edge; /* register each phi gets from either side, by dst */
+    uint32_t blk; /* block at hand */
+    optstats_t *st;
+};
+
+static irins_t *opt_emit(struct opt *o, const irins_t *like, int op)
+{
+    irins_t *in = &o->out[o->size++];
+    *in = *like;
+    in->op = (uint8_t)op;
+    in->dst = in->a = in->b = IR_NOREG;
+    return in;
+}
+
+/* Register holding `v`, putting a constant in a new one now if it's
+ * not in one in this block yet. `at` is the op that needs it. */
+static uint32_t opt_reg(struct opt *o, const irins_t *at, uint32_t v)
+{
+    struct sval *s = &o->val[v];
+    if(s->cnst && (s->reg == IR_NOREG || s->blk != o->blk)) {
+        irins_t *in = opt_emit(o, at, s->imm < 0 ? IR_ICONST : IR_UCONST);
+        in->dst = o->ir->nvregs++;
+        in->imm.i = s->imm;
+        s->reg = in->dst;
+        s->blk = o->blk;
+    }
+    return s->reg;
+}
+
+/* Fold unsigned division or comparison `a OP b`. Returns nonzero if it
+ * can't be done at compile time. */
+static int opt_fold_u(int op, uint64_t a, uint64_t b, int64_t *r)
+{
+    switch(op) {
+    case IR_DIV:
+        /* leave the trap to run time */
+        if(b == 0) {
+            return 1;
+        }
+        *r = (int64_t)(a / b);
+        return 0;
+    case IR_LT:
+        *r = a < b;
+        return 0;
+    case IR_LE:
+        *r = a <= b;
+        return 0;
+    case IR_GT:
+        *r = a > b;
+        return 0;
+    case IR_GE:
+        *r = a >= b;
+        return 0;
+    default:
+        return 1;
+    }
+}
+
+/* Fold `a OP b`, unsigned if `uns` (see ir.h). Returns nonzero if it
+ * can't be done at compile time. */
+static int opt_fold(int op, bool uns, int64_t a, int64_t b, int64_t *r)
+{
+    /* wrap around like the machine does */
+    uint64_t ua = (uint64_t)a, ub = (uint64_t)b;
+    if(uns && op != IR_EQ && op != IR_NE) {
+        return opt_fold_u(op, ua, ub, r);
+    }
+    switch(op) {
+    case IR_ADD:
+        *r = (int64_t)(ua + ub);
+        return 0;
+    case IR_SUB:
+        *r = (int64_t)(ua - ub);
+        return 0;
+    case IR_MUL:
+        *r = (int64_t)(ua * ub);
+        return 0;
+    case IR_DIV:
+        /* leave the trap to run time */
+        if(b == 0 || (a == INT64_MIN && b == -1)) {
+            return 1;
+        }
+        *r = a / b;
+        return 0;
+    case IR_EQ:
+        *r = a == b;
+        return 0;
+    case IR_NE:
+        *r = a != b;
+        return 0;
+    case IR_LT:
+        *r = a < b;
+        return 0;
+    case IR_LE:
+        *r = a <= b;
+        return 0;
+    case IR_GT:
+        *r = a > b;
+        return 0;
+    case IR_GE:
+        *r = a >= b;
+        return 0;
+    default:
+        return 1;
+    }
+}
+
+/* Registers for what the current block hands the phis of block `to`,
+ * put in `o->edge`. `at` is the jump. */
+static void opt_edge(struct opt *o, const irins_t *at, uint32_t to)
+{
+    const ir_t *ir = o->ir;
+    for(size_t i = ir->blocks[to] + 1;
+        i < ir->size && ir->ins[i].op == IR_PHI; i++) {
+        const irins_t *phi = &ir->ins[i];
+        if(phi->imm.blk[0] == o->blk) {
+            o->edge[2 * phi->dst] = opt_reg(o, at, phi->a);
+        }
+        if(phi->b != IR_NOREG && phi->imm.blk[1] == o->blk) {
+            o->edge[2 * phi->dst + 1] = opt_reg(o, at, phi->b);
+        }
+    }
+}
+
+/* Symbolic execution of the ops, see the top of the file. */
+static void opt_values(struct opt *o)
+{
+    ir_t *ir = o->ir;
+    struct sval *val = o->val;
+    for(size_t i = 0; i < ir->size; i++) {
+        const irins_t *in = &ir->ins[i];
+        if(in->dst != IR_NOREG) {
+            val[in->dst] = (struct sval){ .reg = in->dst };
+        }
+
+        switch(in->op) {
+        case IR_ICONST:
+        case IR_UCONST:
+            val[in->dst] = (struct sval){ .cnst = true,
+                                          .reg = IR_NOREG,
+                                          .imm = in->imm.i };
+            break;
+        case IR_ADD:
+        case IR_SUB:
+        case IR_MUL:
+        case IR_DIV:
+        case IR_EQ:
+        case IR_NE:
+        case IR_LT:
+        case IR_LE:
+        case IR_GT:
+        case IR_GE: {
+            /* `a` is either a vreg or an immediate */
+            struct sval a = in->a == IR_NOREG
+                                ? (struct sval){ .cnst = true,
+                                                 .imm = in->imm.i }
+                                : val[in->a];
+            struct sval *b = &val[in->b];
+            int64_t r;
+            if(a.cnst && b->cnst &&
+               !opt_fold(in->op, in->uns, a.imm, b->imm, &r)) {
+                val[in->dst] = (struct sval){ .cnst = true,
+                                              .reg = IR_NOREG,
+                                              .imm = r };
+                o->st->folded++;
+                break;
+            }
+            /* a constant `a` stays an immediate */
+            uint32_t ra = a.cnst ? IR_NOREG : opt_reg(o, in, in->a);
+            uint32_t rb = opt_reg(o, in, in->b);
+            irins_t *out = opt_emit(o, in, in->op);
+            out->a = ra;
+            out->b = rb;
+            out->imm.i = a.imm;
+            out->dst = in->dst;
+            break;
+        }
+        case IR_DUMP:
+        case IR_ARG:
+        case IR_RET: {
+            /* returning nothing */
+            if(in->a == IR_NOREG) {
+                opt_emit(o, in, in->op);
+                break;
+            }
+            uint32_t a = opt_reg(o, in, in->a);
+            opt_emit(o, in, in->op)->a = a;
+            break;
+        }
+        case IR_EXT: {
+            struct sval *a = &val[in->a];
+            if(a->cnst) {
+                val[in->dst] = (struct sval){
+                    .cnst = true,
+                    .reg = IR_NOREG,
+                    .imm = ir_narrow((int)in->imm.i, a->imm)
+                };
+                o->st->folded++;
+                break;
+            }
+            uint32_t ra = opt_reg(o, in, in->a);
+            irins_t *out = opt_emit(o, in, in->op);
+            out->a = ra;
+            out->dst = in->dst;
+            break;
+        }
+        case IR_PARAM:
+        case IR_CALLF:
+        case IR_TAIL:
+        case IR_CALL: {
+            irins_t *out = opt_emit(o, in, in->op);
+            out->dst = in->dst;
+            out->imm = in->imm;
+            break;
+        }
+        case IR_LABEL:
+        case IR_FUNC:
+            /* `func.blk` is `blk[0]` */
+            o->blk = in->imm.blk[0];
+            opt_emit(o, in, in->op);
+            break;
+        case IR_PHI: {
+            /* its operands come from the jumps, see `opt_edge` */
+            irins_t *out = opt_emit(o, in, in->op);
+            out->dst = in->dst;
+            break;
+        }
+        case IR_JMP:
+            opt_edge(o, in, in->imm.blk[0]);
+            opt_emit(o, in, in->op);
+            break;
+        case IR_JNZ: {
+            /* a known condition only ever goes one way, and
+             * `ir_prune` drops the other if nothing else goes there */
+            if(val[in->a].cnst) {
+                uint32_t to = in->imm.blk[val[in->a].imm == 0];
+                opt_edge(o, in, to);
+                opt_emit(o, in, IR_JMP)->imm.blk[0] = to;
+                o->st->folded++;
+                break;
+            }
+            uint32_t a = opt_reg(o, in, in->a);
+            opt_edge(o, in, in->imm.blk[0]);
+            opt_edge(o, in, in->imm.blk[1]);
+            opt_emit(o, in, in->op)->a = a;
+            break;
+        }
+        default:
+            /* the stack shuffles: nothing to do but forget about them */
+            opt_emit(o, in, in->op);
+            break;
+        }
+    }
+
+    for(size_t i = 0; i < o->size; i++) {
+        irins_t *in = &o->out[i];
+        if(in->op == IR_PHI) {
+            in->a = o->edge[2 * in->dst];
+            in->b = o->edge[2 * in->dst + 1];
+        }
+    }
+}
+
+/* Whether `in` can go if its result isn't used. */
+static bool opt_pure(const irins_t *in)
+{
+    switch(in->op) {
+    case IR_ICONST:
+    case IR_UCONST:
+    case IR_ADD:
+    case IR_SUB:
+    case IR_MUL:
+    case IR_PHI:
+    case IR_PARAM:
+    case IR_EXT:
+        return true;
+    default:
+        /* division can trap, calls and the rest do things */
+        return ir_is_cmp(in->op);
+    }
+}
+
+/* Delete pure ops with unused results. Everything impure is used, and
+ * so is whatever a used op reads. */
+static void opt_dce(struct opt *o)
+{
+    size_t nregs = size_max(o->ir->nvregs, 1);
+    bool *live = arena_alloc(&o->ir->arena, nregs);
+    memset(live, 0, nregs);
+    uint32_t *def = arena_alloc(&o->ir->arena, nregs * sizeof(*def));
+    uint32_t *work = arena_alloc(&o->ir->arena, nregs * sizeof(*work));
+    size_t nwork = 0;
+
+    for(size_t i = 0; i < o->size; i++) {
+        const irins_t *in = &o->out[i];
+        if(in->dst != IR_NOREG) {
+            def[in->dst] = (uint32_t)i;
+        }
+        if(opt_pure(in)) {
+            continue;
+        }
+        uint32_t r[2] = { in->a, in->b };
+        for(int k = 0; k < 2; k++) {
+            if(r[k] != IR_NOREG && !live[r[k]]) {
+                live[r[k]] = true;
+                work[nwork++] = r[k];
+            }
+        }
+    }
+    while(nwork > 0) {
+        const irins_t *in = &o->out[def[work[--nwork]]];
+        uint32_t r[2] = { in->a, in->b };
+        for(int k = 0; k < 2; k++) {
+            if(r[k] != IR_NOREG && !live[r[k]]) {
+                live[r[k]] = true;
+                work[nwork++] = r[k];
+            }
+        }
+    }
+
+    /* squeeze the dead ones out */
+    size_t n = 0;
+    for(size_t i = 0; i < o->size; i++) {
+        const irins_t *in = &o->out[i];
+        if(in->dst != IR_NOREG && !live[in->dst] && opt_pure(in)) {
+            continue;
+        }
+        o->out[n++] = *in;
+    }
+    o->size = n;
+}
+
+/* Number the registers that are left 0, 1, 2, ... again, in order. */
+static void opt_renumber(struct opt *o)
+{
+    uint32_t *map = arena_alloc(&o->ir->arena,
+                                size_max(o->ir->nvregs, 1) * sizeof(*map));
+    uint32_t n = 0;
+    for(size_t i = 0; i < o->size; i++) {
+        irins_t *in = &o->out[i];
+        if(in->dst != IR_NOREG) {
+            map[in->dst] = n;
+            in->dst = n++;
+        }
+    }
+    /* phis read values from further down */
+    for(size_t i = 0; i < o->size; i++) {
+        irins_t *in = &o->out[i];
+        if(in->a != IR_NOREG) {
+            in->a = map[in->a];
+        }
+        if(in->b != IR_NOREG) {
+            in->b = map[in->b];
+        }
+    }
+    o->ir->nvregs = n;
+}
+
+/* Whether function `fn` can go inline, being straight-line code of
+ * `max` ops at most that calls none of the others, and returns at the
+ * end, which goes in `*ret`. */
+static bool opt_inlinable(const ir_t *ir, uint32_t fn, size_t max,
+                          uint32_t *ret)
+{
+    const irfunc_t *f = &ir->funcs[fn];
+    if(fn == 0 || !f->leaf || f->start == IR_NOREG) {
+        return false;
+    }
+    size_t n = 0;
+    for(size_t i = f->start + 1; i < ir->size; i++) {
+        const irins_t *in = &ir->ins[i];
+        switch(in->op) {
+        case IR_FUNC:
+        case IR_LABEL:
+        case IR_JMP:
+        case IR_JNZ:
+        case IR_PHI:
+            return false;
+        case IR_RET:
+            *ret = (uint32_t)i;
+            return i + 1 == ir->size || ir->ins[i + 1].op == IR_FUNC;
+        default:
+            n += ir_has_code(in->op) && in->op != IR_PARAM;
+            if(n > max) {
+                return false;
+            }
+        }
+    }
+    return false;
+}
+
+/* Put a copy of the body of every function `opt_inlinable` allows in
+ * place of each call to it. */
+static void opt_inline(ir_t *ir, size_t max, optstats_t *st)
+{
+    uint32_t *ret = arena_alloc(&ir->arena, ir->nfuncs * sizeof(*ret));
+    bool any = false;
+    for(uint32_t k = 0; k < ir->nfuncs; k++) {
+        ret[k] = 0;
+        if(opt_inlinable(ir, k, max, &ret[k])) {
+            any = true;
+        }
+    }
+    if(!any) {
+        return;
+    }
+    size_t grow = 0;
+    for(size_t i = 0; i < ir->size; i++) {
+        const irins_t *in = &ir->ins[i];
+        if((in->op == IR_CALLF || in->op == IR_TAIL) &&
+           ret[in->imm.func.fn] != 0) {
+            /* the body, plus extending or returning the result */
+            grow += ret[in->imm.func.fn] -
+                    ir->funcs[in->imm.func.fn].start;
+        }
+    }
+
+    size_t cap = ir->size + grow;
+    irins_t *out = arena_alloc(&ir->arena, cap * sizeof(*out));
+    /* what call results really are, and the copies' registers */
+    size_t nv = size_max(ir->nvregs + grow, 1);
+    uint32_t *alias = arena_alloc(&ir->arena, nv * sizeof(*alias));
+    memset(alias, 0xff, nv * sizeof(*alias));
+    uint32_t *map = arena_alloc(&ir->arena, nv * sizeof(*map));
+    uint32_t maxp = 1; /* what the parameters of a call are */
+    for(uint32_t k = 0; k < ir->nfuncs; k++) {
+        maxp = ir->funcs[k].nparams > maxp ? ir->funcs[k].nparams : maxp;
+    }
+    uint32_t *pv = arena_alloc(&ir->arena, maxp * sizeof(*pv));
+    size_t n = 0;
+    uint32_t cur = 0; /* function the op is in */
+    for(size_t i = 0; i < ir->size; i++) {
+        const irins_t *in = &ir->ins[i];
+        cur = in->op == IR_FUNC ? in->imm.func.fn : cur;
+        if((in->op != IR_CALLF && in->op != IR_TAIL) ||
+           ret[in->imm.func.fn] == 0) {
+            out[n++] = *in;
+            continue;
+        }
+
+        /* the arguments are the ops right before: narrow ones get cut
+         * down in their place, the rest go */
+        irfunc_t *f = &ir->funcs[in->imm.func.fn];
+        size_t first = n - f->nparams;
+        n = first;
+        for(uint32_t k = 0; k < f->nparams; k++) {
+            irins_t *arg = &out[first + k];
+            pv[k] = arg->a;
+            if(!ir_wide(f->params[k])) {
+                irins_t *ext = &out[n++];
+                *ext = *arg;
+                ext->op = IR_EXT;
+                ext->imm.i = f->params[k];
+                ext->dst = pv[k] = ir->nvregs++;
+            }
+        }
+        for(size_t j = f->start + 1; j < ret[in->imm.func.fn]; j++) {
+            const irins_t *c = &ir->ins[j];
+            if(c->op == IR_PARAM) {
+                map[c->dst] = pv[c->imm.i];
+                continue;
+            }
+            irins_t *to = &out[n++];
+            *to = *c;
+            to->depth += in->depth;
+            to->a = c->a == IR_NOREG ? c->a : map[c->a];
+            to->b = c->b == IR_NOREG ? c->b : map[c->b];
+            if(c->dst != IR_NOREG) {
+                to->dst = map[c->dst] = ir->nvregs++;
+            }
+        }
+        if(in->op == IR_TAIL) {
+            /* the caller's caller extends it the same way */
+            irins_t *r = &out[n++];
+            *r = *in;
+            r->op = IR_RET;
+            r->dst = IR_NOREG;
+            r->a = ir->funcs[cur].ret == IRT_NONE
+                       ? IR_NOREG
+                       : map[ir->ins[ret[in->imm.func.fn]].a];
+        } else if(in->dst != IR_NOREG) {
+            uint32_t r = map[ir->ins[ret[in->imm.func.fn]].a];
+            if(!ir_wide(f->ret)) {
+                irins_t *ext = &out[n++];
+                *ext = *in;
+                ext->op = IR_EXT;
+                ext->a = r;
+                ext->imm.i = f->ret;
+                r = ext->dst = ir->nvregs++;
+            }
+            alias[in->dst] = r;
+        }
+        uint32_t depth = (uint32_t)in->depth + f->maxdepth;
+        if(depth > ir->funcs[cur].maxdepth) {
+            ir->funcs[cur].maxdepth = depth;
+        }
+        if(depth > ir->maxdepth) {
+            ir->maxdepth = depth;
+        }
+        st->inlined++;
+    }
+
+    /* phis read values from further down, so only now is every alias
+     * known */
+    for(size_t i = 0; i < n; i++) {
+        uint32_t *r[2] = { &out[i].a, &out[i].b };
+        for(int k = 0; k < 2; k++) {
+            while(*r[k] != IR_NOREG && alias[*r[k]] != IR_NOREG) {
+                *r[k] = alias[*r[k]];
+            }
+        }
+    }
+    ir->ins = out;
+    ir->size = n;
+    ir->cap = cap;
+    ir_index_blocks(ir);
+}
+
+/* Number of ops of `ir` that turn into code. */
+static size_t opt_count(const irins_t *ins, size_t n)
+{
+    size_t c = 0;
+    for(size_t i = 0; i < n; i++) {
+        c += ir_has_code(ins[i].op);
+    }
+    return c;
+}
+
+/* Optimize `ir` at level `level` (0 does nothing), counting what
+ * happened in `st`. */
+void opt_run(ir_t *ir, int level, optstats_t *st)
+{
+    memset(st, 0, sizeof(*st));
+    st->before = opt_count(ir->ins, ir->size);
+    st->after = st->before;
+    if(level <= 0 || ir->size == 0) {
+        return;
+    }
+    opt_inline(ir, inline_max[level < OPT_MAX ? level : OPT_MAX], st);
+
+    struct opt o = { 0 };
+    o.ir = ir;
+    o.st = st;
+    /* every op puts a constant into a register for one operand at most,
+     * and so does every phi operand */
+    size_t cap = 3 * ir->size;
+    o.out = arena_alloc(&ir->arena, cap * sizeof(*o.out));
+    size_t nv = size_max(ir->nvregs, 1);
+    o.val = arena_alloc(&ir->arena, nv * sizeof(*o.val));
+    o.edge = arena_alloc(&ir->arena, 2 * nv * sizeof(*o.edge));
+    memset(o.edge, 0xff, 2 * nv * sizeof(*o.edge));
+
+    opt_values(&o);
+    /* branches that folded, and functions that went inline everywhere,
+     * leave code nothing gets to */
+    ir->ins = o.out;
+    ir->size = o.size;
+    ir->cap = cap;
+    ir_index_blocks(ir);
+    ir_prune(ir);
+    o.size = ir->size;
+    opt_dce(&o);
+    opt_renumber(&o);
+
+    ir->size = o.size;
+    ir_index_blocks(ir);
+    st->after = opt_count(ir->ins, ir->size);
+}
+
+/* Print what `opt_run` did to `to`. */
+void opt_stats(const optstats_t *st, FILE *to)
+{
+    /* inlining can make more than there was */
+    bool more = st->after > st->before;
+    fprintf(to,
+            "opt: %zu -> %zu instructions (%zu %s), %zu folded, "
+            "%zu calls inlined\n",
+            st->before, st->after,
+            more ? st->after - st->before : st->before - st->after,
+            more ? "added" : "removed", st->folded, st->inlined);
+}
@@ -0,0 +1,33 @@
+/*
+ * Copyright (C) 2025 therealblue24.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Header file for the IR optimizer.
+ */
+#ifndef OPT_H_
+#define OPT_H_
+
+#include "util.h"
+#include "ir.h"
+
+/* highest optimization level that does anything */
+#define OPT_MAX 2
+
+/* What `opt_run` did. */
+typedef struct optstats {
+    size_t before, after; /* ops that turn into code */
+    size_t folded; /* arithmetic done at compile time */
+    size_t inlined; /* calls replaced by the function's body */
+} optstats_t;
+
+/* Optimize `ir` at level `level` (0 does nothing), counting what
+ * happened in `st`. Level 1 inlines tiny functions, 2 bigger ones. */
+void opt_run(ir_t *ir, int level, optstats_t *st);
+
+/* Print what `opt_run` did to `to`. */
+void opt_stats(const optstats_t *st, FILE *to);
+
+#endif /* OPT_H_ */
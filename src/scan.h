@@ -0,0 +1,47 @@
+/*
+ * Copyright (C) 2025 therealblue24.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Header file for bulk byte scanning used by the lexer.
+ */
+#ifndef SCAN_H_
+#define SCAN_H_
+
+#include "util.h"
+
+/* Scanner implementations. */
+enum scan_isa {
+    SCAN_AUTO = 0, /* SSE2 where there is one, else scalar */
+    SCAN_SCALAR, /* plain C, always available */
+    SCAN_SSE2, /* 16 bytes at a time */
+    SCAN_AVX2, /* 32 bytes at a time */
+};
+
+/* Select the scanner implementation. Unsupported ones fall back
+ * to the next best. Returns the one that got selected. */
+enum scan_isa scan_select(enum scan_isa isa);
+
+/* Select the best implementation, unless one was already selected. */
+void scan_init(void);
+
+/* Name of scanner implementation `isa`. */
+const char *scan_isa_name(enum scan_isa isa);
+
+/* All of these look at `buf[pos..len)` and return the offset of the
+ * first byte that matches, or `len` if there is none. */
+
+/* First whitespace byte (isspace() in the C locale). */
+size_t scan_ws(const uint8_t *buf, size_t pos, size_t len);
+/* First non-whitespace byte. */
+size_t scan_nonws(const uint8_t *buf, size_t pos, size_t len);
+/* First '"' or '\\' -- the interesting bytes inside a string literal. */
+size_t scan_strlit(const uint8_t *buf, size_t pos, size_t len);
+/* First '/' or '*' -- the interesting bytes inside a block comment. */
+size_t scan_comment(const uint8_t *buf, size_t pos, size_t len);
+/* First newline. */
+size_t scan_newline(const uint8_t *buf, size_t pos, size_t len);
+
+#endif /* SCAN_H_ */
@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2025 therealblue24.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Mapping source offsets to lines and columns.
+ */
+#include "srcloc.h"
+#include "scan.h"
+
+/* Point `map` at `buf` with length `len`, dropping any old index. */
+void srcmap_init(srcmap_t *map, const uint8_t *buf, size_t len)
+{
+    map->buf = buf;
+    map->len = len;
+    map->lines.size = 0;
+    map->built = false;
+}
+
+/* Forget the index, e.g. after `buf` changed. */
+void srcmap_invalidate(srcmap_t *map)
+{
+    map->lines.size = 0;
+    map->built = false;
+}
+
+/* One pass over the buffer, newline to newline. */
+static void srcmap_build(srcmap_t *map)
+{
+    map->lines.size = 0;
+    list_append(&map->lines, 0); /* line 1 */
+    size_t nl = 0;
+    while((nl = scan_newline(map->buf, nl, map->len)) < map->len) {
+        nl++;
+        list_append(&map->lines, nl);
+    }
+    map->built = true;
+}
+
+/* Source location of offset `off`. Builds the index if needed. */
+srcloc_t srcmap_loc(srcmap_t *map, size_t off)
+{
+    if(!map->built) {
+        srcmap_build(map);
+    }
+
+    /* last line that starts at or before `off` */
+    size_t lo = 0, hi = map->lines.size;
+    while(hi - lo > 1) {
+        size_t mid = lo + (hi - lo) / 2;
+        if(map->lines.elems[mid] <= off) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+
+    size_t start = map->lines.elems[lo];
+    srcloc_t loc;
+    loc.line = lo + 1;
+    loc.col = off - start;
+    loc.line_src = map->buf + start;
+    loc.line_len = scan_newline(map->buf, start, map->len) - start;
+    return loc;
+}
+
+/* Free the index. */
+void srcmap_free(srcmap_t *map)
+{
+    free(map->lines.elems);
+    map->lines.elems = NULL;
+    map->lines.size = map->lines.cap = 0;
+    map->built = false;
+}
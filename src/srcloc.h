@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2025 therealblue24.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Header file for mapping source offsets to lines and columns.
+ */
+#ifndef SRCLOC_H_
+#define SRCLOC_H_
+
+#include "util.h"
+
+/* Source location of an offset. */
+typedef struct srcloc {
+    size_t line; /* 1-indexed */
+    size_t col; /* 0-indexed */
+    const uint8_t *line_src; /* start of the line */
+    size_t line_len; /* length of the line, without the newline */
+} srcloc_t;
+
+/* Line index of a source buffer. Nothing is computed until the
+ * first lookup, so sources that never get a diagnostic never pay
+ * for it. */
+typedef struct srcmap {
+    const uint8_t *buf;
+    size_t len;
+    /* offset of the start of every line, valid if `built` */
+    LIST(size_t) lines;
+    bool built;
+} srcmap_t;
+
+/* Point `map` at `buf` with length `len`, dropping any old index. */
+void srcmap_init(srcmap_t *map, const uint8_t *buf, size_t len);
+
+/* Forget the index, e.g. after `buf` changed. */
+void srcmap_invalidate(srcmap_t *map);
+
+/* Source location of offset `off`. Builds the index if needed. */
+srcloc_t srcmap_loc(srcmap_t *map, size_t off);
+
+/* Free the index. */
+void srcmap_free(srcmap_t *map);
+
+/* Print a diagnostic for `hl` bytes at offset `off` of `map`. */
+#define SRC_DIAG(label, name, map, off, hl, ...)                          \
+    do {                                                                  \
+        srcloc_t loc_ = srcmap_loc((map), (off));                         \
+        print_generic((label), (name), loc_.line, loc_.col,               \
+                      loc_.line_src, loc_.line_len, (hl), __VA_ARGS__);   \
+    } while(0);
+
+#endif /* SRCLOC_H_ */
@@ -8,18 +8,20 @@
  * String literal parsing
  */
 #include "strl.h"
+#include "scan.h"
 
-/* Generated from `tools/escapetab.c`.
- * -1 = parse octal, -2 = parse hex   */
+/* Generated from `tools/escapegen.c`.
+ * -1 = parse octal, -2 = parse hex,
+ * -3 = parse \u (4 hex digits), -4 = parse \U (8 hex digits) */
 static const int escapetab[256] = {
     0,   1,   2,   3,   4,   5,   6,   7,   8,   9,   10,  11,  12,  13,  14,
     15,  16,  17,  18,  19,  20,  21,  22,  23,  24,  25,  26,  27,  28,  29,
     30,  31,  32,  33,  34,  35,  36,  37,  38,  39,  40,  41,  42,  43,  44,
     45,  46,  47,  -1,  -1,  -1,  -1,  -1,  -1,  -1,  -1,  56,  57,  58,  59,
     60,  61,  62,  63,  64,  65,  66,  67,  68,  69,  70,  71,  72,  73,  74,
-    75,  76,  77,  78,  79,  80,  81,  82,  83,  84,  85,  86,  87,  88,  89,
+    75,  76,  77,  78,  79,  80,  81,  82,  83,  84,  -4,  86,  87,  88,  89,
     90,  91,  92,  93,  94,  95,  96,  7,   8,   99,  100, 27,  12,  103, 104,
-    105, 106, 107, 108, 109, 10,  111, 112, 113, 13,  115, 9,   117, 11,  119,
+    105, 106, 107, 108, 109, 10,  111, 112, 113, 13,  115, 9,   -3,  11,  119,
     -2,  121, 122, 123, 124, 125, 126, 127, 128, 129, 130, 131, 132, 133, 134,
     135, 136, 137, 138, 139, 140, 141, 142, 143, 144, 145, 146, 147, 148, 149,
     150, 151, 152, 153, 154, 155, 156, 157, 158, 159, 160, 161, 162, 163, 164,
@@ -32,33 +34,92 @@ static const int escapetab[256] = {
     255
 };
 
+/* Value of hex digit `c`, or -1. */
+static int hexval(int c)
+{
+    if(c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    c |= 0x20; /* lowercase */
+    if(c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    return -1;
+}
+
+/* Read up to `max` hex digits at `src[*i..size)` into `*val`.
+ * Returns the number of digits read. */
+static size_t strl_hex(const uint8_t *src, size_t size, size_t *i, size_t max,
+                       uint32_t *val)
+{
+    size_t n = 0;
+    uint32_t v = 0;
+    int d;
+    while(n < max && *i < size && (d = hexval(src[*i])) >= 0) {
+        v = (v << 4) | (uint32_t)d;
+        (*i)++;
+        n++;
+    }
+    *val = v;
+    return n;
+}
+
+/* UTF-8 encode code point `cp` into `dst`. Returns the bytes written. */
+static size_t strl_utf8(uint32_t cp, uint8_t *dst)
+{
+    if(cp < 0x80) {
+        dst[0] = (uint8_t)cp;
+        return 1;
+    }
+    if(cp < 0x800) {
+        dst[0] = (uint8_t)(0xc0 | (cp >> 6));
+        dst[1] = (uint8_t)(0x80 | (cp & 0x3f));
+        return 2;
+    }
+    if(cp < 0x10000) {
+        dst[0] = (uint8_t)(0xe0 | (cp >> 12));
+        dst[1] = (uint8_t)(0x80 | ((cp >> 6) & 0x3f));
+        dst[2] = (uint8_t)(0x80 | (cp & 0x3f));
+        return 3;
+    }
+    dst[0] = (uint8_t)(0xf0 | (cp >> 18));
+    dst[1] = (uint8_t)(0x80 | ((cp >> 12) & 0x3f));
+    dst[2] = (uint8_t)(0x80 | ((cp >> 6) & 0x3f));
+    dst[3] = (uint8_t)(0x80 | (cp & 0x3f));
+    return 4;
+}
+
 /* Parses a string literal `src` into an actual string `dst`,
  * given size of the string literal `size`. Assumes that
  * dst is sized enough to fit the output of `src`.
- * Returns zero on failure, else size of `dst`. */
+ * Returns STRL_ERR on failure, else size of `dst`. */
 size_t strl_parse(const uint8_t *src, uint8_t *dst, size_t size)
 {
     size_t j = 0;
     size_t i = 0;
     /* skip beginning " */
-    if(*src == '\"') {
+    if(size && *src == '\"') {
         i++;
     }
 
     while(i < size) {
-        /* don't want to emit the extra closing " */
-        if(i == (size - 1) && src[i] == '\"')
+        /* copy everything up to the next quote or backslash in one go */
+        size_t run = scan_strlit(src, i, size) - i;
+        memcpy(dst + j, src + i, run);
+        i += run;
+        j += run;
+        if(i >= size) {
             break;
+        }
 
-        /* If we don't encounter an escape sequence yet */
-        if(src[i] != '\\') {
-            dst[j++] = src[i++];
-            continue; /* go on */
+        /* the closing ", which has to be the last thing */
+        if(src[i] == '\"') {
+            return i == size - 1 ? j : STRL_ERR;
         }
 
         /* should not be possible as lexer would also trip up */
         if(i == (size - 1)) {
-            return 0;
+            return STRL_ERR;
         }
 
         i++; /* get the actual char */
@@ -66,14 +127,52 @@ size_t strl_parse(const uint8_t *src, uint8_t *dst, size_t size)
         /* if we dont have to parse number */
         if(d >= 0) {
             /* emit it, continue on */
-            dst[j++] = d;
+            dst[j++] = (uint8_t)d;
             i++;
             continue;
         }
 
         /* else we have to parse the number */
-        TODO("Number parsing in string literals");
+        uint32_t val = 0;
+        switch(d) {
+        case -1: /* \NNN, up to 3 octal digits */
+            for(size_t n = 0; n < 3 && i < size && src[i] >= '0' &&
+                              src[i] <= '7';
+                n++) {
+                val = (val << 3) | (uint32_t)(src[i++] - '0');
+            }
+            if(val > 0xff) {
+                return STRL_ERR;
+            }
+            dst[j++] = (uint8_t)val;
+            break;
+        case -2: /* \xHH */
+            i++;
+            if(strl_hex(src, size, &i, 2, &val) == 0) {
+                return STRL_ERR;
+            }
+            dst[j++] = (uint8_t)val;
+            break;
+        case -3: /* \uHHHH */
+        case -4: /* \UHHHHHHHH */
+        {
+            size_t want = d == -3 ? 4 : 8;
+            i++;
+            if(strl_hex(src, size, &i, want, &val) != want) {
+                return STRL_ERR;
+            }
+            /* no surrogates, nothing past the last plane */
+            if((val >= 0xd800 && val <= 0xdfff) || val > 0x10ffff) {
+                return STRL_ERR;
+            }
+            j += strl_utf8(val, dst + j);
+            break;
+        }
+        default:
+            return STRL_ERR;
+        }
     }
 
-    return j;
+    /* no closing " */
+    return STRL_ERR;
 }
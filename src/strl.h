@@ -12,10 +12,15 @@
 
 #include "util.h"
 
+/* strl_parse() failed */
+#define STRL_ERR ((size_t)-1)
+
 /* Parses a string literal `src` into an actual string `dst`,
  * given size of the string literal `size`. Assumes that
  * dst is sized enough to fit the output of `src`.
- * Returns zero on failure, else size of `dst`. */
+ * Handles the usual C escapes, including octal, \xHH, \uHHHH and
+ * \UHHHHHHHH (as UTF-8).
+ * Returns STRL_ERR on failure, else size of `dst`. */
 size_t strl_parse(const uint8_t *src, uint8_t *dst, size_t size);
 
 #endif /* STRL_H_ */
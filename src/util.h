@@ -104,7 +104,7 @@ static inline size_t size_max(size_t a, size_t b)
     do {                                                                      \
         if((sz) >= (l)->cap) {                                                \
             while((sz) >= (l)->cap) {                                         \
-                l->cap = size_max(LIST_INITIAL_CAP, (l)->cap * 2);            \
+                (l)->cap = size_max(LIST_INITIAL_CAP, (l)->cap * 2);          \
             }                                                                 \
             (l)->elems = realloc((l)->elems, (l)->cap * sizeof(*(l)->elems)); \
             ASSERT((l)->elems, "failed to reallocate %zu %zu-byte list!",     \
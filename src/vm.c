@@ -0,0 +1,354 @@
+/*
+ * Copyright (C) 2025 therealblue24.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Bytecode VM: compiling tokens to threaded code, and running it.
+ */
+#include "vm.h"
+#include "jit.h"
+#include "depth.h"
+#include <inttypes.h>
+
+/* operand words after each op */
+static const uint8_t nargs[VM_COUNT] = {
+    [VM_PUSH] = 1,    [VM_CALL] = 1,    [VM_JMP] = 1,     [VM_JZ] = 1,
+    [VM_ADDI] = 1,    [VM_SUBI] = 1,    [VM_MULI] = 1,    [VM_DIVI] = 1,
+    [VM_DUPADDI] = 1, [VM_DUPSUBI] = 1, [VM_DUPMULI] = 1,
+};
+
+static const uint8_t binops[TOK__COUNTR] = {
+    [TOK_ADD] = VM_ADD, [TOK_SUB] = VM_SUB, [TOK_MUL] = VM_MUL,
+    [TOK_DIV] = VM_DIV, [TOK_EQ] = VM_EQ,   [TOK_NE] = VM_NE,
+    [TOK_LT] = VM_LT,   [TOK_LE] = VM_LE,   [TOK_GT] = VM_GT,
+    [TOK_GE] = VM_GE,
+};
+
+/* Fusion rules: op `first` right before op `second` becomes `fused`,
+ * with the operands of both, counted as pattern `pat`. They chain,
+ * `dup N +` goes PUSH ADD -> ADDI, then DUP ADDI -> DUPADDI, which
+ * takes the count from `undo`. The fused op reports errors at the
+ * token of `second`, or `first` if `at_first`, where the unfused code
+ * would have. */
+static const struct {
+    uint8_t first, second, fused;
+    int8_t pat, undo;
+    bool at_first;
+} rules[] = {
+    { VM_PUSH, VM_ADD, VM_ADDI, FUSE_NUM_OP, -1, false },
+    { VM_PUSH, VM_SUB, VM_SUBI, FUSE_NUM_OP, -1, false },
+    { VM_PUSH, VM_MUL, VM_MULI, FUSE_NUM_OP, -1, false },
+    { VM_PUSH, VM_DIV, VM_DIVI, FUSE_NUM_OP, -1, false },
+    { VM_DUP, VM_DUMP, VM_DUPDUMP, FUSE_DUP_DUMP, -1, true },
+    { VM_DUP, VM_ADDI, VM_DUPADDI, FUSE_DUP_NUM_OP, FUSE_NUM_OP, true },
+    { VM_DUP, VM_SUBI, VM_DUPSUBI, FUSE_DUP_NUM_OP, FUSE_NUM_OP, true },
+    { VM_DUP, VM_MULI, VM_DUPMULI, FUSE_DUP_NUM_OP, FUSE_NUM_OP, true },
+};
+#define NRULES (sizeof(rules) / sizeof(rules[0]))
+
+/* Report `err` at the token `at` (a word of checked threaded code)
+ * came from. */
+static void vm_fail(const vmprog_t *p, lex_t *lex, const vmword_t *at,
+                    const char *err)
+{
+    token_t tok;
+    lex_tok(lex, p->tok.elems[at - p->threaded[1]], &tok);
+    LEX_ERR(lex, (size_t)(tok.raw - lex->buf), tok.range, "%s", err);
+}
+
+#define VM_LOOP vm_loop_checked
+#define VM_CHECKED 1
+#include "vmloop.h"
+#undef VM_LOOP
+#undef VM_CHECKED
+
+#define VM_LOOP vm_loop_fast
+#define VM_CHECKED 0
+#include "vmloop.h"
+#undef VM_LOOP
+#undef VM_CHECKED
+
+/* An `if` or `while` being compiled. */
+struct vmctl {
+    int kind; /* TOK_IF, TOK_THEN, TOK_ELSE, TOK_WHILE or TOK_DO */
+    size_t head; /* loops: where the condition starts */
+    size_t fix; /* operand of the jump past what's next */
+};
+
+/* Compiler state. */
+struct vmc {
+    vmprog_t *p;
+    lex_t *lex;
+    LIST(size_t) ops; /* where each op starts in `p->code` */
+    LIST(struct vmctl) ctl; /* open `if`s and `while`s */
+    bool fuse;
+};
+
+static void vm_word(vmprog_t *p, vmword_t w, uint32_t tok)
+{
+    list_append(&p->code, w);
+    list_append(&p->tok, tok);
+}
+
+/* Fuse the last two ops for as long as there's a rule for them. */
+static void vm_fuse(struct vmc *c)
+{
+    vmprog_t *p = c->p;
+    while(c->ops.size >= 2) {
+        size_t i = c->ops.elems[c->ops.size - 2];
+        size_t j = c->ops.elems[c->ops.size - 1];
+        size_t r = 0;
+        while(r < NRULES && (rules[r].first != p->code.elems[i].op ||
+                             rules[r].second != p->code.elems[j].op)) {
+            r++;
+        }
+        if(r == NRULES) {
+            return;
+        }
+
+        /* drop the word of `second`, its operands move down */
+        uint32_t tok = p->tok.elems[rules[r].at_first ? i : j];
+        size_t n = p->code.size - j - 1;
+        memmove(&p->code.elems[j], &p->code.elems[j + 1],
+                n * sizeof(*p->code.elems));
+        memmove(&p->tok.elems[j], &p->tok.elems[j + 1],
+                n * sizeof(*p->tok.elems));
+        p->code.size--;
+        p->tok.size--;
+        p->code.elems[i].op = rules[r].fused;
+        p->tok.elems[i] = tok;
+        c->ops.size--;
+
+        p->fused.fused[rules[r].pat]++;
+        if(rules[r].undo >= 0) {
+            p->fused.fused[rules[r].undo]--;
+        }
+    }
+}
+
+/* Emit op `op` from token `tok`, with operand `arg` if it takes one. */
+static void vm_op(struct vmc *c, int op, uint32_t tok, vmword_t arg)
+{
+    list_append(&c->ops, c->p->code.size);
+    vm_word(c->p, (vmword_t){ .op = op }, tok);
+    if(nargs[op]) {
+        vm_word(c->p, arg, tok);
+    }
+    if(c->fuse) {
+        vm_fuse(c);
+    }
+}
+
+/* Emit jump `op` to word `to` from token `tok`.
+ * Returns where its operand is, to point it somewhere else later. */
+static size_t vm_jump(struct vmc *c, int op, uint32_t tok, size_t to)
+{
+    vm_op(c, op, tok, (vmword_t){ .imm = (int64_t)to });
+    c->ops.size = 0;
+    return c->p->code.size - 1;
+}
+
+/* A jump target, here. */
+static size_t vm_here(struct vmc *c)
+{
+    /* fusing across it would move it */
+    c->ops.size = 0;
+    return c->p->code.size;
+}
+
+/* Control flow keyword `it`, token number `tok`, which `depth_check`
+ * has seen in its place. */
+static void vm_control(struct vmc *c, const token_t *it, uint32_t tok)
+{
+    vmprog_t *p = c->p;
+    struct vmctl *k = c->ctl.size > 0 ? &c->ctl.elems[c->ctl.size - 1]
+                                      : NULL;
+
+    switch(it->toktype) {
+    case TOK_IF:
+    case TOK_WHILE: {
+        struct vmctl n = { .kind = (int)it->toktype, .head = vm_here(c) };
+        list_append(&c->ctl, n);
+        return;
+    }
+    case TOK_THEN:
+    case TOK_DO:
+        k->kind = (int)it->toktype;
+        k->fix = vm_jump(c, VM_JZ, tok, 0);
+        return;
+    case TOK_ELSE: {
+        size_t fix = vm_jump(c, VM_JMP, tok, 0);
+        p->code.elems[k->fix].imm = (int64_t)vm_here(c);
+        k->kind = TOK_ELSE;
+        k->fix = fix;
+        return;
+    }
+    case TOK_END: {
+        struct vmctl e = *k;
+        c->ctl.size--;
+        if(e.kind == TOK_DO) {
+            vm_jump(c, VM_JMP, tok, e.head);
+        }
+        p->code.elems[e.fix].imm = (int64_t)vm_here(c);
+        return;
+    }
+    default:
+        return;
+    }
+}
+
+/* Compile the tokens of `lex` into `p`, fusing sequences if `fuse`,
+ * and reporting errors through `lex`.
+ * Returns nonzero on failure. */
+int vm_compile(vmprog_t *p, lex_t *lex, bool fuse)
+{
+    memset(p, 0, sizeof(*p));
+    /* only `main`: functions are for the JIT */
+    irfunc_t main = { .ret = IRT_L, .end = (uint32_t)lex->toks.size };
+    for(uint32_t i = 0; i < lex->toks.size; i++) {
+        if(lex->toks.type[i] == TOK_FUNC) {
+            LEX_ERR(lex, lex->toks.start[i], lex->toks.len[i],
+                    "the VM doesn't do functions, use --run");
+            return 1;
+        }
+    }
+    if(depth_check(lex, &main, 1, NULL)) {
+        return 1;
+    }
+    p->maxdepth = main.maxdepth;
+
+    int failed = 0;
+    struct vmc c = { .p = p, .lex = lex, .fuse = fuse };
+    const vmword_t none = { 0 };
+
+    tokiter_t iter = { 0 };
+    token_t it;
+    while(lex_iter(lex, &iter, &it)) {
+        uint32_t tok = (uint32_t)(iter.i - 1);
+        switch(it.toktype) {
+        case TOK_ADD:
+        case TOK_SUB:
+        case TOK_MUL:
+        case TOK_DIV:
+        case TOK_EQ:
+        case TOK_NE:
+        case TOK_LT:
+        case TOK_LE:
+        case TOK_GT:
+        case TOK_GE:
+            vm_op(&c, binops[it.toktype], tok, none);
+            break;
+        case TOK_DUP:
+            vm_op(&c, VM_DUP, tok, none);
+            break;
+        case TOK_DROP:
+            vm_op(&c, VM_DROP, tok, none);
+            break;
+        case TOK_DROPALL:
+            vm_op(&c, VM_DROPALL, tok, none);
+            break;
+        case TOK_SWAP:
+            vm_op(&c, VM_SWAP, tok, none);
+            break;
+        case TOK_OVER:
+            vm_op(&c, VM_OVER, tok, none);
+            break;
+        case TOK_DUMP:
+            vm_op(&c, VM_DUMP, tok, none);
+            break;
+        case TOK_RET:
+            vm_op(&c, VM_RET, tok, none);
+            break;
+        case TOK_NUM_INT:
+        case TOK_NUM_INTU:
+            vm_op(&c, VM_PUSH, tok, (vmword_t){ .imm = it.tok_num.signd });
+            break;
+        case TOK_SPECIAL_LIT: {
+            const void *fn = jit_lookup(lex, (uint32_t)(it.raw - lex->buf),
+                                        (uint32_t)it.range);
+            failed |= !fn;
+            /* POSIX says data and function pointers convert */
+            vm_op(&c, VM_CALL, tok,
+                  (vmword_t){ .fn = (int64_t (*)(void))fn });
+            break;
+        }
+        case TOK_IF:
+        case TOK_THEN:
+        case TOK_ELSE:
+        case TOK_WHILE:
+        case TOK_DO:
+        case TOK_END:
+            vm_control(&c, &it, tok);
+            continue;
+        default:
+            LEX_ERR(lex, (size_t)(it.raw - lex->buf), it.range,
+                    "unsupported op");
+            failed = 1;
+            goto out;
+        }
+    }
+    vm_op(&c, VM_HALT, (uint32_t)lex->toks.size, none);
+
+out:
+    free(c.ops.elems);
+    free(c.ctl.elems);
+    if(failed) {
+        vm_free(p);
+        return 1;
+    }
+    return 0;
+}
+
+/* The ops of `p` swapped for the handlers in `labels`. */
+static vmword_t *vm_thread(const vmprog_t *p, const void **labels)
+{
+    vmword_t *t = zcalloc(p->code.size, sizeof(*t));
+    for(size_t i = 0; i < p->code.size;) {
+        intptr_t op = p->code.elems[i].op;
+        t[i++].lbl = labels[op];
+        if(op == VM_JMP || op == VM_JZ) {
+            t[i].to = t + p->code.elems[i].imm;
+            i++;
+            continue;
+        }
+        for(int k = 0; k < nargs[op]; k++, i++) {
+            t[i] = p->code.elems[i];
+        }
+    }
+    return t;
+}
+
+/* Run `p`, putting what it returns in `*ret`. `checked` catches
+ * division traps, reporting them through `lex`; the stack needs no
+ * checks, `vm_compile` made sure of it.
+ * Returns nonzero if a check failed. */
+int vm_run(vmprog_t *p, lex_t *lex, bool checked, int64_t *ret)
+{
+    int (*loop)(const vmprog_t *, lex_t *, const vmword_t *, int64_t *,
+                int64_t *, const void **) =
+        checked ? vm_loop_checked : vm_loop_fast;
+    /* threaded once per mode, then kept */
+    if(!p->threaded[checked]) {
+        const void *labels[VM_COUNT];
+        loop(p, lex, NULL, NULL, NULL, labels);
+        p->threaded[checked] = vm_thread(p, labels);
+    }
+
+    /* as deep as it gets, plus the dummy under the bottom */
+    int64_t *stack = zcalloc((size_t)p->maxdepth + 1, sizeof(*stack));
+    int r = loop(p, lex, p->threaded[checked], stack, ret, NULL);
+    free(stack);
+    return r;
+}
+
+/* Free `p`. */
+void vm_free(vmprog_t *p)
+{
+    free(p->code.elems);
+    free(p->tok.elems);
+    free(p->threaded[0]);
+    free(p->threaded[1]);
+    memset(p, 0, sizeof(*p));
+}
@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2025 therealblue24.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Header file for the bytecode VM.
+ *
+ * Tokens compile to a flat array of words: an op, then its operands.
+ * Before running, every op word is swapped for the address of its
+ * handler, and handlers jump straight to the next one (direct threaded
+ * code, with computed goto). The top of the stack lives in a local,
+ * the rest in an array exactly as deep as the program needs, which
+ * `depth_check` works out before anything runs: the stack never gets
+ * checked at run time.
+ *
+ * Common sequences compile to one fused op (see fuse.h), numbers in
+ * them to an immediate operand.
+ *
+ * `if` and `while` compile to jumps, whose operand is the word index
+ * of their target until threading makes it a pointer. Nothing fuses
+ * across a jump or its target.
+ */
+#ifndef VM_H_
+#define VM_H_
+
+#include "util.h"
+#include "lex.h"
+#include "fuse.h"
+
+/* VM ops. */
+enum vmop {
+    VM_PUSH, /* imm */
+    VM_ADD,
+    VM_SUB,
+    VM_MUL,
+    VM_DIV,
+    VM_EQ,
+    VM_NE,
+    VM_LT,
+    VM_LE,
+    VM_GT,
+    VM_GE,
+    VM_DUP,
+    VM_DROP,
+    VM_DROPALL,
+    VM_SWAP,
+    VM_OVER,
+    VM_DUMP,
+    VM_CALL, /* fn */
+    VM_RET,
+    VM_JMP, /* to */
+    VM_JZ, /* to, pops the condition */
+    VM_HALT, /* end of the program */
+    /* fused */
+    VM_ADDI, /* imm, `N +` */
+    VM_SUBI, /* imm, `N -` */
+    VM_MULI, /* imm, `N *` */
+    VM_DIVI, /* imm, `N /` */
+    VM_DUPDUMP, /* `dup dump` */
+    VM_DUPADDI, /* imm, `dup N +` */
+    VM_DUPSUBI, /* imm, `dup N -` */
+    VM_DUPMULI, /* imm, `dup N *` */
+
+    VM_COUNT,
+};
+
+/* One word of code. */
+typedef union vmword {
+    intptr_t op; /* VM_*, before threading */
+    const void *lbl; /* handler, after threading */
+    int64_t imm; /* jumps store their target here before threading */
+    int64_t (*fn)(void);
+    const union vmword *to;
+} vmword_t;
+
+/* Compiled program. */
+typedef struct vmprog {
+    LIST(vmword_t) code; /* ops as VM_* */
+    LIST(uint32_t) tok; /* token of every word, for diagnostics */
+    vmword_t *threaded[2]; /* `code` with handlers, [checked] */
+    uint32_t maxdepth; /* deepest the stack gets */
+    fusestats_t fused;
+} vmprog_t;
+
+/* Compile the tokens of `lex` into `p`, fusing sequences if `fuse`,
+ * and reporting errors through `lex`, a `func` among them: the VM only
+ * runs programs without functions.
+ * Returns nonzero on failure. */
+int vm_compile(vmprog_t *p, lex_t *lex, bool fuse);
+
+/* Run `p`, putting what it returns in `*ret`. `checked` catches
+ * division traps, reporting them through `lex`; the stack needs no
+ * checks, `vm_compile` made sure of it.
+ * Returns nonzero if a check failed. */
+int vm_run(vmprog_t *p, lex_t *lex, bool checked, int64_t *ret);
+
+/* Free `p`. */
+void vm_free(vmprog_t *p);
+
+#endif /* VM_H_ */
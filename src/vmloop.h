@@ -0,0 +1,193 @@
+/*
+ * Copyright (C) 2025 therealblue24.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * The VM's interpreter loop. vm.c includes this once per mode, with
+ * VM_LOOP naming the function and VM_CHECKED saying whether division
+ * traps get caught, so neither mode pays for the other. The stack
+ * never needs checking, see `depth_check`.
+ *
+ * The stack: `tos` is the top, `sp` points at the value under it, and
+ * `base[0]` is a dummy under the bottom, so the depth is `sp - base`.
+ */
+
+/* on to the next op */
+#define NEXT goto *(pc++)->lbl
+
+/* Run `code`, `p` threaded for this loop, on `stack` (`p->maxdepth`
+ * + 1 values). If `labels` isn't NULL, just put this loop's handlers there. */
+static int VM_LOOP(const vmprog_t *p, lex_t *lex, const vmword_t *code,
+                   int64_t *stack, int64_t *ret, const void **labels)
+{
+    static const void *const handlers[VM_COUNT] = {
+        [VM_PUSH] = &&op_push, [VM_ADD] = &&op_add,
+        [VM_SUB] = &&op_sub,   [VM_MUL] = &&op_mul,
+        [VM_DIV] = &&op_div,   [VM_EQ] = &&op_eq,
+        [VM_NE] = &&op_ne,     [VM_LT] = &&op_lt,
+        [VM_LE] = &&op_le,     [VM_GT] = &&op_gt,
+        [VM_GE] = &&op_ge,     [VM_DUP] = &&op_dup,
+        [VM_DROP] = &&op_drop, [VM_DROPALL] = &&op_dropall,
+        [VM_SWAP] = &&op_swap, [VM_OVER] = &&op_over,
+        [VM_DUMP] = &&op_dump, [VM_CALL] = &&op_call,
+        [VM_RET] = &&op_ret,   [VM_JMP] = &&op_jmp,
+        [VM_JZ] = &&op_jz,     [VM_HALT] = &&op_halt,
+        [VM_ADDI] = &&op_addi, [VM_SUBI] = &&op_subi,
+        [VM_MULI] = &&op_muli, [VM_DIVI] = &&op_divi,
+        [VM_DUPDUMP] = &&op_dupdump, [VM_DUPADDI] = &&op_dupaddi,
+        [VM_DUPSUBI] = &&op_dupsubi, [VM_DUPMULI] = &&op_dupmuli,
+    };
+    if(labels) {
+        memcpy(labels, handlers, sizeof(handlers));
+        return 0;
+    }
+
+    const vmword_t *pc = code;
+    int64_t *const base = stack;
+    int64_t *sp = base;
+    int64_t tos = 0;
+    const char *err = NULL;
+    (void)p, (void)lex, (void)err;
+    NEXT;
+
+op_push:
+    *++sp = tos;
+    tos = (pc++)->imm;
+    NEXT;
+op_add:
+    /* wrap around like the machine does */
+    tos = (int64_t)((uint64_t)tos + (uint64_t)*sp--);
+    NEXT;
+op_sub:
+    tos = (int64_t)((uint64_t)tos - (uint64_t)*sp--);
+    NEXT;
+op_mul:
+    tos = (int64_t)((uint64_t)tos * (uint64_t)*sp--);
+    NEXT;
+op_div:
+#if VM_CHECKED
+    if(*sp == 0) {
+        err = "division by zero";
+        goto fail;
+    }
+    if(*sp == -1 && tos == INT64_MIN) {
+        err = "division overflow";
+        goto fail;
+    }
+#endif
+    tos /= *sp--;
+    NEXT;
+    /* top of the stack first, like the arithmetic */
+op_eq:
+    tos = tos == *sp--;
+    NEXT;
+op_ne:
+    tos = tos != *sp--;
+    NEXT;
+op_lt:
+    tos = tos < *sp--;
+    NEXT;
+op_le:
+    tos = tos <= *sp--;
+    NEXT;
+op_gt:
+    tos = tos > *sp--;
+    NEXT;
+op_ge:
+    tos = tos >= *sp--;
+    NEXT;
+op_dup:
+    *++sp = tos;
+    NEXT;
+op_drop:
+    tos = *sp--;
+    NEXT;
+op_dropall:
+    sp = base;
+    NEXT;
+op_swap: {
+    int64_t t = tos;
+    tos = *sp;
+    *sp = t;
+    NEXT;
+}
+op_over:
+    *++sp = tos;
+    tos = sp[-1];
+    NEXT;
+op_dump:
+    printf("%" PRIu64 "\n", (uint64_t)tos);
+    tos = *sp--;
+    NEXT;
+op_call: {
+    int64_t (*fn)(void) = (pc++)->fn;
+    *++sp = tos;
+    tos = fn();
+    NEXT;
+}
+op_ret:
+    *ret = tos;
+    return 0;
+op_jmp:
+    pc = pc->to;
+    NEXT;
+op_jz: {
+    int64_t c = tos;
+    tos = *sp--;
+    pc = c ? pc + 1 : pc->to;
+    NEXT;
+}
+op_halt:
+    *ret = 0;
+    return 0;
+
+    /* fused ops, a check comes before `pc` moves on to the immediate */
+op_addi:
+    tos = (int64_t)((uint64_t)(pc++)->imm + (uint64_t)tos);
+    NEXT;
+op_subi:
+    tos = (int64_t)((uint64_t)(pc++)->imm - (uint64_t)tos);
+    NEXT;
+op_muli:
+    tos = (int64_t)((uint64_t)(pc++)->imm * (uint64_t)tos);
+    NEXT;
+op_divi:
+#if VM_CHECKED
+    if(tos == 0) {
+        err = "division by zero";
+        goto fail;
+    }
+    if(tos == -1 && pc->imm == INT64_MIN) {
+        err = "division overflow";
+        goto fail;
+    }
+#endif
+    tos = (pc++)->imm / tos;
+    NEXT;
+op_dupdump:
+    printf("%" PRIu64 "\n", (uint64_t)tos);
+    NEXT;
+op_dupaddi:
+    *++sp = tos;
+    tos = (int64_t)((uint64_t)(pc++)->imm + (uint64_t)tos);
+    NEXT;
+op_dupsubi:
+    *++sp = tos;
+    tos = (int64_t)((uint64_t)(pc++)->imm - (uint64_t)tos);
+    NEXT;
+op_dupmuli:
+    *++sp = tos;
+    tos = (int64_t)((uint64_t)(pc++)->imm * (uint64_t)tos);
+    NEXT;
+
+#if VM_CHECKED
+fail:
+    /* `pc` is past the op word */
+    vm_fail(p, lex, pc - 1, err);
+    return 1;
+#endif
+}
+
+#undef NEXT
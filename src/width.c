@@ -0,0 +1,304 @@
+/*
+ * Copyright (C) 2025 therealblue24.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Width analysis.
+ */
+#include "width.h"
+
+static int width_max(int a, int b)
+{
+    return a > b ? a : b;
+}
+
+/* Bits of IRT_* `ty`. */
+static int width_bits(int ty)
+{
+    switch(ty) {
+    case IRT_B:
+    case IRT_UB:
+        return 8;
+    case IRT_H:
+    case IRT_UH:
+        return 16;
+    case IRT_W:
+    case IRT_UW:
+        return 32;
+    default:
+        return 64;
+    }
+}
+
+/* Whether IRT_* `ty` has no negative values. */
+static bool width_unsigned(int ty)
+{
+    return ty == IRT_UB || ty == IRT_UH || ty == IRT_UW || ty == IRT_UL;
+}
+
+/* Bits a signed type needs to hold IRT_* `ty`. */
+static int width_sbits(int ty)
+{
+    return width_bits(ty) + width_unsigned(ty);
+}
+
+/* Narrowest IRT_* of `bits` bits at most, unsigned if `u`, IRT_L if
+ * they're more than 32. */
+static int width_make(bool u, int bits)
+{
+    if(bits <= 8) {
+        return u ? IRT_UB : IRT_B;
+    }
+    if(bits <= 16) {
+        return u ? IRT_UH : IRT_H;
+    }
+    if(bits <= 32) {
+        return u ? IRT_UW : IRT_W;
+    }
+    return IRT_L;
+}
+
+/* Narrowest IRT_* that holds both `a` and `b`, IRT_NONE being no
+ * values at all. */
+static int width_join(int a, int b)
+{
+    if(a == IRT_NONE || b == IRT_NONE) {
+        return a == IRT_NONE ? b : a;
+    }
+    /* only the types make an IRT_UL, nothing else needs 64 bits
+     * unsigned */
+    if(a == IRT_UL || b == IRT_UL) {
+        return width_unsigned(a) && width_unsigned(b) ? IRT_UL : IRT_L;
+    }
+    if(width_unsigned(a) && width_unsigned(b)) {
+        return width_make(true, width_max(width_bits(a), width_bits(b)));
+    }
+    return width_make(false, width_max(width_sbits(a), width_sbits(b)));
+}
+
+/* Narrowest IRT_* that holds `v`. */
+int width_const(int64_t v)
+{
+    /* bits of the magnitude, plus the sign for negative ones */
+    uint64_t m = v < 0 ? ~(uint64_t)v : (uint64_t)v;
+    int bits = m == 0 ? 0 : 64 - __builtin_clzll(m);
+    return v < 0 ? width_make(false, bits + 1) : width_make(true, bits);
+}
+
+/* Whether every value of IRT_* `ty` is one of `into` as well. */
+bool width_fits(int ty, int into)
+{
+    return width_join(ty, into) == into;
+}
+
+/* IRT_* of what binop `op` makes of IRT_*s `a` and `b`. */
+static int width_binop(int op, int a, int b)
+{
+    bool u = width_unsigned(a) && width_unsigned(b);
+    int bits = width_max(width_bits(a), width_bits(b));
+    int sbits = width_max(width_sbits(a), width_sbits(b));
+    /* arithmetic on an IRT_UL wraps around like unsigned numbers do, as
+     * long as the other side can't be negative either */
+    if(u && (a == IRT_UL || b == IRT_UL) && !ir_is_cmp(op)) {
+        return IRT_UL;
+    }
+    switch(op) {
+    case IR_ADD:
+        return u ? width_make(true, bits + 1) : width_make(false, sbits + 1);
+    case IR_SUB:
+        return width_make(false, sbits + 1);
+    case IR_MUL:
+        return u ? width_make(true, width_bits(a) + width_bits(b))
+                 : width_make(false, width_sbits(a) + width_sbits(b));
+    case IR_DIV:
+        /* it only gets smaller, but the most negative value over -1
+         * doesn't */
+        return u ? a : width_make(false, width_sbits(a) + 1);
+    default:
+        /* comparisons, 1 or 0 */
+        return IRT_UB;
+    }
+}
+
+/* IRT_* of every register of `ir`, the narrowest that holds every
+ * value it can have (IRT_L if there's nothing narrower). Freed by the
+ * caller. */
+uint8_t *width_infer(const ir_t *ir)
+{
+    /* IRT_NONE until something's known: loops go around until nothing
+     * changes, and every register only ever gets wider */
+    uint8_t *w = zcalloc(size_max(ir->nvregs, 1), sizeof(*w));
+    bool changed = true;
+    while(changed) {
+        changed = false;
+        const irfunc_t *f = ir->funcs;
+        for(size_t i = 0; i < ir->size; i++) {
+            const irins_t *in = &ir->ins[i];
+            if(in->op == IR_FUNC) {
+                f = &ir->funcs[in->imm.func.fn];
+            }
+            if(in->dst == IR_NOREG) {
+                continue;
+            }
+            int ty;
+            switch(in->op) {
+            case IR_ICONST:
+            case IR_UCONST:
+                ty = width_const(in->imm.i);
+                break;
+            case IR_PARAM:
+                ty = f->params[in->imm.i];
+                break;
+            case IR_EXT:
+                ty = (int)in->imm.i;
+                break;
+            case IR_CALLF:
+                ty = ir->funcs[in->imm.func.fn].ret;
+                break;
+            case IR_PHI:
+                ty = width_join(w[in->a],
+                                in->b == IR_NOREG ? IRT_NONE : w[in->b]);
+                break;
+            default:
+                if(!ir_is_binop(in->op)) {
+                    ty = IRT_L;
+                    break;
+                }
+                int a = in->a == IR_NOREG ? width_const(in->imm.i) : w[in->a];
+                /* only phis read what comes later, wait for it */
+                ty = a == IRT_NONE || w[in->b] == IRT_NONE
+                         ? IRT_NONE
+                         : width_binop(in->op, a, w[in->b]);
+                break;
+            }
+            ty = width_join(w[in->dst], ty);
+            if(ty != w[in->dst]) {
+                w[in->dst] = (uint8_t)ty;
+                changed = true;
+            }
+        }
+    }
+    for(uint32_t v = 0; v < ir->nvregs; v++) {
+        w[v] = w[v] == IRT_NONE ? IRT_L : w[v];
+    }
+    return w;
+}
+
+/* Whether op `op` is a sum, difference or product. */
+static bool width_arith(int op)
+{
+    return op == IR_ADD || op == IR_SUB || op == IR_MUL;
+}
+
+/* Whether anything reads more than the low 32 bits of each register of
+ * `ir`, for every register. Freed by the caller. */
+bool *width_wide(const ir_t *ir)
+{
+    bool *wide = zcalloc(size_max(ir->nvregs, 1), sizeof(*wide));
+    /* arguments of the calls coming up */
+    LIST(uint32_t) args = { 0 };
+    const irfunc_t *f = ir->funcs;
+    for(size_t i = 0; i < ir->size; i++) {
+        const irins_t *in = &ir->ins[i];
+        switch(in->op) {
+        case IR_FUNC:
+            f = &ir->funcs[in->imm.func.fn];
+            break;
+        case IR_ARG:
+            list_append(&args, in->a);
+            break;
+        case IR_CALLF:
+        case IR_TAIL: {
+            const irfunc_t *g = &ir->funcs[in->imm.func.fn];
+            args.size -= g->nparams;
+            for(uint32_t k = 0; k < g->nparams; k++) {
+                wide[args.elems[args.size + k]] |= ir_wide(g->params[k]);
+            }
+            break;
+        }
+        case IR_RET:
+            if(in->a != IR_NOREG) {
+                wide[in->a] |= ir_wide(f->ret);
+            }
+            break;
+        case IR_EXT:
+            wide[in->a] |= ir_wide((int)in->imm.i);
+            break;
+        default:
+            /* everything else reads it all, arithmetic below, and the
+             * stack shuffles turn into nothing */
+            if(width_arith(in->op) || !ir_has_code(in->op)) {
+                break;
+            }
+            if(in->a != IR_NOREG) {
+                wide[in->a] = true;
+            }
+            if(in->b != IR_NOREG) {
+                wide[in->b] = true;
+            }
+            break;
+        }
+    }
+    free(args.elems);
+    /* then arithmetic something reads all of needs all of what goes in,
+     * going around until that's settled */
+    bool changed = true;
+    while(changed) {
+        changed = false;
+        for(size_t i = ir->size; i-- > 0;) {
+            const irins_t *in = &ir->ins[i];
+            if(!width_arith(in->op) || !wide[in->dst]) {
+                continue;
+            }
+            if(in->a != IR_NOREG && !wide[in->a]) {
+                wide[in->a] = changed = true;
+            }
+            if(!wide[in->b]) {
+                wide[in->b] = changed = true;
+            }
+        }
+    }
+    return wide;
+}
+
+/* How to do op `in`, a division or comparison, with the registers
+ * `width_infer` gave `widths`: IRT_UW for 32 bits unsigned, IRT_W for
+ * 32 bits signed, IRT_L for all 64, IRT_UL for all 64 unsigned. */
+int width_op(const uint8_t *widths, const irins_t *in)
+{
+    int a = in->a == IR_NOREG ? width_const(in->imm.i) : widths[in->a];
+    int b = widths[in->b];
+    if(width_fits(a, IRT_UW) && width_fits(b, IRT_UW)) {
+        return IRT_UW;
+    }
+    /* unsigned ones stay that way, even if the optimizer made something
+     * of them that looks negative */
+    if(in->uns) {
+        return IRT_UL;
+    }
+    /* the most negative `w` over -1 doesn't fit in a `w` */
+    if(width_fits(a, IRT_W) && width_fits(b, IRT_W) &&
+       (in->op != IR_DIV || width_sbits(a) < 32)) {
+        return IRT_W;
+    }
+    return IRT_L;
+}
+
+/* Set `uns` on the divisions and comparisons of `ir`, as `ir_build`
+ * made it, where neither side can be negative. */
+void width_signs(ir_t *ir)
+{
+    uint8_t *w = width_infer(ir);
+    for(size_t i = 0; i < ir->size; i++) {
+        irins_t *in = &ir->ins[i];
+        in->uns = false;
+        if(in->op == IR_DIV || (ir_is_cmp(in->op) && in->op != IR_EQ &&
+                                in->op != IR_NE)) {
+            int a = in->a == IR_NOREG ? width_const(in->imm.i) : w[in->a];
+            in->uns = width_unsigned(a) && width_unsigned(w[in->b]);
+        }
+    }
+    free(w);
+}
@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2025 therealblue24.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Header file for the width analysis.
+ *
+ * Every value on the stack is 64 bits, but a lot of them can't be that
+ * big: parameters and results of narrow types, comparisons, constants,
+ * and what arithmetic on those makes. Following the values through the
+ * stack (and around loops, through the phis) gives each one the
+ * narrowest IRT_* that holds everything it can be. The backends use
+ * that to do division and comparisons in 32 bits where the answer
+ * comes out the same, and `width_wide` finds the arithmetic that can
+ * be done in 32 bits because only the low ones of it get read.
+ *
+ * It also decides what's signed, once, on what `ir_build` makes (see
+ * `width_signs`): division and comparisons are unsigned where neither
+ * side can be negative. Only the types make values unsigned that need
+ * all 64 bits, IRT_UL, and arithmetic on those wraps around like
+ * unsigned numbers do, as long as the other side can't be negative
+ * either. Everything else that needs 64 bits is IRT_L, and signed.
+ */
+#ifndef WIDTH_H_
+#define WIDTH_H_
+
+#include "util.h"
+#include "ir.h"
+
+/* IRT_* of every register of `ir`, the narrowest that holds every
+ * value it can have (IRT_L if there's nothing narrower). Freed by the
+ * caller. */
+uint8_t *width_infer(const ir_t *ir);
+
+/* Whether anything reads more than the low 32 bits of each register of
+ * `ir`, for every register. Narrow results, parameters and extensions
+ * don't, and neither do sums, differences and products nothing reads
+ * more of: their low bits only depend on the low bits going in. Freed
+ * by the caller. */
+bool *width_wide(const ir_t *ir);
+
+/* Narrowest IRT_* that holds `v`. */
+int width_const(int64_t v);
+
+/* Whether every value of IRT_* `ty` is one of `into` as well. */
+bool width_fits(int ty, int into);
+
+/* How to do op `in`, a division or comparison, with the registers
+ * `width_infer` gave `widths`: IRT_UW for 32 bits unsigned, IRT_W for
+ * 32 bits signed, IRT_L for all 64, IRT_UL for all 64 unsigned. */
+int width_op(const uint8_t *widths, const irins_t *in);
+
+/* Set `uns` on the divisions and comparisons of `ir`, as `ir_build`
+ * made it, where neither side can be negative. */
+void width_signs(ir_t *ir);
+
+#endif /* WIDTH_H_ */
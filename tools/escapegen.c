@@ -52,7 +52,10 @@ int one(uint8_t byte)
         return -1;
     case 'x':
         return -2;
-        /* no unicode support yet */
+    case 'u':
+        return -3;
+    case 'U':
+        return -4;
     default:
         return (int)byte;
     }
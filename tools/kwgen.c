@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2025 therealblue24.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Generator for the perfect-hash keyword table (src/kwtab.h)
+ */
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../src/kwlist.h"
+
+/* keyword -> `enum toktype` member, from src/kwlist.h */
+static const struct {
+    const char *nam;
+    const char *tok;
+} keywords[] = {
+#define K(nam, tok) { nam, "TOK_" #tok },
+    KEYWORDS(K)
+#undef K
+};
+
+#define KEYWORD_COUNT (sizeof(keywords) / sizeof(keywords[0]))
+
+/* table size, must be a power of two */
+#define TABSZ 128
+
+/* Must match kw_hash() in the generated header. */
+static uint32_t kw_hash(const uint8_t *s, size_t len, uint32_t seed)
+{
+    uint32_t h = seed ^ (uint32_t)len;
+    for(size_t i = 0; i < len; i++) {
+        h = (h ^ s[i]) * 0x01000193u;
+    }
+    return (h ^ (h >> 15)) & (TABSZ - 1);
+}
+
+/* Try `seed`, filling `slots`. Returns nonzero if there is a collision. */
+static int try_seed(uint32_t seed, int slots[TABSZ])
+{
+    for(int i = 0; i < TABSZ; i++) {
+        slots[i] = -1;
+    }
+    for(size_t i = 0; i < KEYWORD_COUNT; i++) {
+        const char *nam = keywords[i].nam;
+        uint32_t h = kw_hash((const uint8_t *)nam, strlen(nam), seed);
+        if(slots[h] != -1) {
+            return 1;
+        }
+        slots[h] = (int)i;
+    }
+    return 0;
+}
+
+int main(void)
+{
+    int slots[TABSZ];
+    uint32_t seed = 0;
+    size_t maxlen = 0;
+
+    while(try_seed(seed, slots)) {
+        seed++;
+    }
+
+    for(size_t i = 0; i < KEYWORD_COUNT; i++) {
+        size_t l = strlen(keywords[i].nam);
+        maxlen = l > maxlen ? l : maxlen;
+    }
+
+    printf("/* Generated from `tools/kwgen.c`, do not edit. */\n");
+    printf("#ifndef KWTAB_H_\n#define KWTAB_H_\n\n");
+    printf("#define KW_SEED %uu\n", seed);
+    printf("#define KW_TABSZ %d\n", TABSZ);
+    printf("#define KW_MAXLEN %zu\n", maxlen);
+    printf("#define KW_COUNT %zu\n\n", KEYWORD_COUNT);
+    printf("struct kwslot {\n");
+    printf("    char nam[KW_MAXLEN + 1];\n");
+    printf("    uint8_t len; /* zero if the slot is empty */\n");
+    printf("    uint8_t tok;\n");
+    printf("};\n\n");
+    printf("static inline uint32_t kw_hash(const uint8_t *s, size_t len)\n");
+    printf("{\n");
+    printf("    uint32_t h = KW_SEED ^ (uint32_t)len;\n");
+    printf("    for(size_t i = 0; i < len; i++) {\n");
+    printf("        h = (h ^ s[i]) * 0x01000193u;\n");
+    printf("    }\n");
+    printf("    return (h ^ (h >> 15)) & (KW_TABSZ - 1);\n");
+    printf("}\n\n");
+    printf("static const struct kwslot kwtab[KW_TABSZ] = {\n");
+    for(int i = 0; i < TABSZ; i++) {
+        if(slots[i] == -1) {
+            continue;
+        }
+        const char *nam = keywords[slots[i]].nam;
+        printf("    [%3d] = { \"%s\", %zu, %s },\n", i, nam, strlen(nam),
+               keywords[slots[i]].tok);
+    }
+    printf("};\n\n");
+    printf("#endif /* KWTAB_H_ */\n");
+    return 0;
+}